@@ -0,0 +1,59 @@
+//
+// Copyright (c) 2019-2020 Kris Jusiak (kris at jusiak dot net)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+#include <boost/ut.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+// Throughput of passing assertions, built with -O0 like most test builds.
+// Prints the best of a few repetitions in ns per assertion, using no newer
+// API so that it can be built against older versions of ut.hpp to compare.
+int main() {
+  using namespace boost::ut;
+
+  static constexpr auto iterations = 1'000'000;
+  static constexpr auto repetitions = 5;
+
+  const auto measure = [](const char* name, auto assertions) {
+    return [=] {
+      auto best = std::chrono::duration<double, std::nano>::max();
+      for (auto r = 0; r < repetitions; ++r) {
+        const auto start = std::chrono::steady_clock::now();
+        assertions();
+        best = std::min<std::chrono::duration<double, std::nano>>(
+            best, std::chrono::steady_clock::now() - start);
+      }
+      std::printf("%s: %.1f ns per assertion\n", name,
+                  best.count() / iterations);
+    };
+  };
+
+  "expect_udl"_test = measure("expect_udl", [] {
+    for (auto i = 0; i < iterations; ++i) {
+      expect(i == _i(i));
+    }
+  });
+
+  "expect_that"_test = measure("expect_that", [] {
+    for (auto i = 0; i < iterations; ++i) {
+      expect(that % i == i);
+    }
+  });
+
+  "expect_eq"_test = measure("expect_eq", [] {
+    for (auto i = 0; i < iterations; ++i) {
+      expect(eq(i, i));
+    }
+  });
+
+  "expect_bool"_test = measure("expect_bool", [] {
+    for (auto i = 0; i < iterations; ++i) {
+      expect(i >= 0);
+    }
+  });
+}
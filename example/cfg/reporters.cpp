@@ -0,0 +1,35 @@
+//
+// Copyright (c) 2019-2020 Kris Jusiak (kris at jusiak dot net)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+#include <boost/ut.hpp>
+#include <iostream>
+
+namespace ut = boost::ut;
+
+namespace cfg {
+class progress {
+ public:
+  auto on(ut::events::test_end) -> void { std::clog << '.'; }
+  auto on(ut::events::summary) -> void { std::clog << '\n'; }
+};
+}  // namespace cfg
+
+// console output, a JUnit report (`-r junit -o report.xml`) and a progress
+// line from a single run
+template <>
+auto ut::cfg<ut::override> =
+    ut::runner<ut::reporters<ut::reporter<ut::printer>,
+                             ut::reporter_junit<ut::printer>, cfg::progress>>{};
+
+int main(int argc, const char** argv) {
+  using namespace ut;
+
+  "first"_test = [] { expect(42_i == 42); };
+  "second"_test = [] { expect(1_i != 2); };
+
+  return ut::cfg<ut::override>.run({.argc = argc, .argv = argv});
+}
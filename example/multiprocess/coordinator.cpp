@@ -4,7 +4,6 @@
 #include <boost/ut.hpp>
 #include <fstream>
 #include <chrono>
-#include <thread>
 #include <cstdlib>
 #include <filesystem>
 
@@ -66,19 +65,8 @@ int main() {
     }
     
     // Wait for both processes to be ready
-    int attempts = 0;
-    while (attempts < 100) {  // 10 seconds timeout
-      if (are_processes_ready()) {
-        expect(true) << "Both processes are ready";
-        break;
-      }
-      std::this_thread::sleep_for(std::chrono::milliseconds(100));
-      attempts++;
-    }
-    
-    if (attempts >= 100) {
-      expect(false) << "Timeout waiting for processes to start";
-    }
+    expect(eventually(are_processes_ready, std::chrono::seconds(10)))
+        << "Timeout waiting for processes to start";
   };
   
   // Test 3: Monitor process completion
@@ -89,19 +77,8 @@ int main() {
     }
     
     // Wait for both processes to complete
-    int attempts = 0;
-    while (attempts < 100) {  // 10 seconds timeout
-      if (are_processes_completed()) {
-        expect(true) << "Both processes completed successfully";
-        break;
-      }
-      std::this_thread::sleep_for(std::chrono::milliseconds(100));
-      attempts++;
-    }
-    
-    if (attempts >= 100) {
-      expect(false) << "Timeout waiting for processes to complete";
-    }
+    expect(eventually(are_processes_completed, std::chrono::seconds(10)))
+        << "Timeout waiting for processes to complete";
   };
   
   // Test 4: Coordinator-specific functionality
@@ -1,9 +1,50 @@
 module;
 
 #if __has_include(<unistd.h>) and __has_include(<sys/wait.h>)
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #endif
+#if __has_include(<sys/mman.h>) and __has_include(<sys/stat.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if __has_include(<sys/stat.h>)
+#include <sys/stat.h>
+#endif
+#if __has_include(<execinfo.h>)
+#include <execinfo.h>
+#endif
+#if __has_include(<ucontext.h>) and __has_include(<sys/mman.h>)
+#include <setjmp.h>
+#include <signal.h>
+#include <ucontext.h>
+#endif
+#if defined(BOOST_UT_RUN_TOOLS)
+#if __has_include(<dirent.h>) and __has_include(<unistd.h>)
+#include <dirent.h>
+#include <unistd.h>
+#endif
+#if __has_include(<execinfo.h>) and __has_include(<sys/time.h>)
+#include <errno.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <time.h>
+#endif
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#endif
+#if __has_include(<malloc.h>)
+#include <malloc.h>
+#endif
+#endif
+#if defined(BOOST_UT_USDT) and __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#endif
 
 export module boost.ut;
 export import std;
@@ -33,6 +33,19 @@
 #define BOOST_UT_HAS_FORMAT
 #endif
 
+#if defined(BOOST_UT_USDT) and __has_include(<sys/sdt.h>)
+#define BOOST_UT_HAS_USDT
+#endif
+
+// BOOST_UT_RUN_TOOLS adds the tooling of whole runs (--durations-file,
+// --time-budget, --journal, --bisect-pollution, --leak-check, --profile,
+// --soak and the reports of interrupted runs), which is opt-in as it slows
+// down compiling every test.
+#if defined(BOOST_UT_RUN_TOOLS) and __has_include(<unistd.h>) and \
+    __has_include(<sys/wait.h>)
+#define BOOST_UT_HAS_POSIX_RUN_TOOLS  // processes and signals
+#endif
+
 #if not defined(__cpp_rvalue_references)
 #error "[Boost::ext].UT requires support for rvalue references";
 #elif not defined(__cpp_decltype)
@@ -69,30 +82,94 @@
 #define __has_builtin(...) __has_##__VA_ARGS__
 #endif
 
+// The passing assertion path is inlined even in unoptimized builds, where
+// assertion heavy tests would otherwise spend their time in call layers.
+// GNU attribute syntax, as it also applies to the call operator of lambdas.
+#if defined(__GNUC__) or defined(__clang__)
+#define BOOST_UT_ALWAYS_INLINE __attribute__((always_inline))
+#define BOOST_UT_NOINLINE __attribute__((noinline))
+#else
+#define BOOST_UT_ALWAYS_INLINE
+#define BOOST_UT_NOINLINE
+#endif
+
 #if !defined(BOOST_UT_CXX_MODULES)
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <charconv>
 #include <chrono>
 #include <concepts>
+#include <condition_variable>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
 #include <fstream>
 #include <functional>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <new>
 #include <optional>
 #include <sstream>
 #include <stack>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <tuple>
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <variant>
 #include <vector>
 #if __has_include(<unistd.h>) and __has_include(<sys/wait.h>)
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #endif
+#if __has_include(<sys/mman.h>) and __has_include(<sys/stat.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if __has_include(<sys/stat.h>)
+#include <sys/stat.h>
+#endif
+#if __has_include(<execinfo.h>)
+#include <execinfo.h>
+#endif
+#if __has_include(<ucontext.h>) and __has_include(<sys/mman.h>)
+#include <setjmp.h>
+#include <signal.h>
+#include <ucontext.h>
+#endif
+#if defined(BOOST_UT_RUN_TOOLS)
+#include <map>
+#include <set>
+#if __has_include(<dirent.h>) and __has_include(<unistd.h>)
+#include <dirent.h>
+#include <unistd.h>
+#endif
+#if __has_include(<execinfo.h>) and __has_include(<sys/time.h>)
+#include <errno.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <time.h>
+#endif
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#endif
+#if __has_include(<malloc.h>)
+#include <malloc.h>
+#endif
+#endif
+#if defined(BOOST_UT_HAS_USDT)
+#include <sys/sdt.h>
+#endif
 #if defined(__cpp_exceptions)
 #include <exception>
 #endif
@@ -571,6 +648,7 @@ struct test {
   std::string_view type{};
   std::string name{};  /// might be dynamic
   std::vector<std::string_view> tag{};
+  std::size_t max_stack{};  /// bytes, see ut::max_stack
   reflection::source_location location{};
   TArg arg{};
   Test run{};
@@ -632,14 +710,14 @@ struct assertion {
 };
 template <class TExpr>
 assertion(TExpr, reflection::source_location) -> assertion<TExpr>;
-template <class TExpr>
+template <class TExpr = none>
 struct assertion_pass {
   TExpr expr{};
   reflection::source_location location{};
 };
 template <class TExpr>
 assertion_pass(TExpr) -> assertion_pass<TExpr>;
-template <class TExpr>
+template <class TExpr = none>
 struct assertion_fail {
   TExpr expr{};
   reflection::source_location location{};
@@ -650,17 +728,29 @@ struct test_end {
   std::string_view type{};
   std::string_view name{};
 };
-template <class TMsg>
+template <class TMsg = std::string_view>
 struct log {
   TMsg msg{};
 };
-template <class TMsg = std::string_view>
+template <class TMsg>
 log(TMsg) -> log<TMsg>;
 struct fatal_assertion : std::exception {};
 struct exception {
   const char* msg{};
   [[nodiscard]] auto what() const -> const char* { return msg; }
 };
+struct metric {
+  std::string_view name{};
+  std::string_view kind{};
+  double value{};
+};
+struct parallel_begin {};
+struct parallel_end {};
+/// the threads of a load test (see rate) start and stop calling the runner,
+/// load_worker on each of them but the thread of the test
+struct load_begin {};
+struct load_worker {};
+struct load_end {};
 struct summary {};
 }  // namespace events
 
@@ -681,8 +771,8 @@ struct cfg {
                                  std::reference_wrapper<std::size_t>,
                                  std::reference_wrapper<std::string>>;
   using option = std::tuple<std::string, std::string, value_ref, std::string>;
-  static inline reflection::source_location location{};
-  static inline bool wip{};
+  static inline thread_local reflection::source_location location{};
+  static inline thread_local bool wip{};
 
 #if defined(_MSC_VER)
   static inline int largc = __argc;
@@ -716,6 +806,21 @@ struct cfg {
   static inline std::string use_colour = "yes";  // <- done
   static inline bool show_lib_identity = false;  // <- done
   static inline std::string wait_for_keypress = "never";
+  static inline bool last_failed = false;
+  static inline std::string state_file;
+  static inline std::size_t stack_usage = 0;
+  static inline std::string trace_markers;
+#if defined(BOOST_UT_RUN_TOOLS)
+  static inline std::string bisect_pollution;
+  static inline std::string journal;
+  static inline std::string resume;
+  static inline std::string replay;
+  static inline std::string leak_check = "off";
+  static inline std::string profile;
+  static inline std::string soak;
+  static inline std::string durations_file;
+  static inline std::string time_budget;
+#endif
 
   static inline const std::vector<option> options = {
       // clang-format off
@@ -738,19 +843,65 @@ struct cfg {
   {"--rng-seed", "<'time'|number>", std::ref(rnd_seed), "set a specific seed for random numbers"},
   {"--use-colour", "<yes|no>", std::ref(use_colour), "should output be colourised"},
   {"--libidentify", "", std::ref(show_lib_identity), "report name and version according to libidentify standard"},
-  {"--wait-for-keypress", "<never|start|exit|both>", std::ref(wait_for_keypress), "waits for a keypress before exiting"}
+  {"--wait-for-keypress", "<never|start|exit|both>", std::ref(wait_for_keypress), "waits for a keypress before exiting"},
+  {"--last-failed", "", std::ref(last_failed), "only run tests which failed in the previous run"},
+  {"--state-file", "<filename|none>", std::ref(state_file), "run state file (off by default, <executable>.ut-state with --last-failed)"},
+  {"--stack-usage", "<bytes>", std::ref(stack_usage), "run tests on a stack of the given size and report how much they use"},
+  {"--trace-markers", "<ftrace|filename>", std::ref(trace_markers), "write suite and test boundaries to the ftrace trace_marker or a file"},
+#if defined(BOOST_UT_RUN_TOOLS)
+  {"--durations-file", "<filename|none>", std::ref(durations_file), "durations of previous runs, to flag tests which got slower (off by default, <executable>.ut-durations with --time-budget)"},
+  {"--time-budget", "<duration>", std::ref(time_budget), "only run the tests most likely to fail (per second) which fit in the duration, e.g. 90s"},
+  {"--bisect-pollution", "<test name>", std::ref(bisect_pollution), "find the earlier tests which make the given test fail"},
+  {"--journal", "<filename>", std::ref(journal), "append the outcome of each completed test to a journal"},
+  {"--resume", "<journal>", std::ref(resume), "skip the tests completed in the journal and continue it"},
+  {"--replay", "<journal>", std::ref(replay), "run the journaled tests of the worker of the last failure again"},
+  {"--leak-check", "<off|warn|fail>", std::ref(leak_check), "report threads, fds and child processes left behind by a test"},
+  {"--profile", "<filename>", std::ref(profile), "sample the tests and write their folded stacks, for flame graphs"},
+  {"--soak", "<duration>", std::ref(soak), "loop every selected test for the duration (e.g. 2h), failing it when its resources or duration keep growing"},
+#endif
       // clang-format on
   };
 
   static std::optional<cfg::option> find_arg(std::string_view arg) {
     for (const auto& option : cfg::options) {
-      if (std::get<0>(option).find(arg) != std::string::npos) {
-        return option;
+      for (auto names = std::string_view{std::get<0>(option)};
+           not names.empty();) {
+        const auto end = std::min(names.find_first_of(", "), names.size());
+        if (names.substr(0, end) == arg) {
+          return option;
+        }
+        names.remove_prefix(std::min(end + 1, names.size()));
       }
     }
     return std::nullopt;
   }
 
+  /// file persisting the state of the previous run, empty unless a
+  /// --state-file is given or --last-failed uses the default one
+  [[nodiscard]] static auto run_state_file() -> std::string {
+    if (state_file == "none") {
+      return {};
+    }
+    if (not state_file.empty() or not last_failed or largc == 0) {
+      return state_file;
+    }
+    return executable_name + ".ut-state";
+  }
+
+#if defined(BOOST_UT_RUN_TOOLS)
+  /// empty unless a --durations-file is given or --time-budget uses the
+  /// default one
+  [[nodiscard]] static auto run_durations_file() -> std::string {
+    if (durations_file == "none") {
+      return {};
+    }
+    if (not durations_file.empty() or time_budget.empty() or largc == 0) {
+      return durations_file;
+    }
+    return executable_name + ".ut-durations";
+  }
+#endif
+
   static void print_usage() {
     std::size_t opt_width = 30;
     std::cout << cfg::executable_name
@@ -827,8 +978,12 @@ struct cfg {
       i += 1;  // skip to next argv for parsing
       if (std::holds_alternative<std::reference_wrapper<std::size_t>>(var)) {
         // parse size argument
-        std::size_t last;
         std::string argument(argv[i]);
+        if (argument == "time") {  // --rng-seed time
+          std::get<std::reference_wrapper<std::size_t>>(var).get() = 0;
+          continue;
+        }
+        std::size_t last;
         auto val = static_cast<std::size_t>(std::stoull(argument, &last));
         if (last != argument.length()) {
           std::cerr << "cannot parse option of " << argv[i - 1] << " "
@@ -875,1362 +1030,4938 @@ struct cfg {
   }
 };
 
-template <class T>
-[[nodiscard]] constexpr auto get_impl(const T& t, int) -> decltype(t.get()) {
-  return t.get();
-}
-template <class T>
-[[nodiscard]] constexpr auto get_impl(const T& t, ...) -> decltype(auto) {
-  return t;
-}
-template <class T>
-[[nodiscard]] constexpr auto get(const T& t) {
-  return get_impl(t, 0);
-}
+/// What the run tooling needs of the file system, with <cstdio> and POSIX
+/// rather than <filesystem>, which is slow to compile
+class files {
+ public:
+  struct status {
+    std::uintmax_t size{};
+    std::int64_t modified{};  // ns since the epoch
+    bool regular{};           // file
+  };
 
-template <class T>
-struct type_ : op {
-  template <class TOther>
-  // NOLINTNEXTLINE(readability-const-return-type)
-  [[nodiscard]] constexpr auto operator()(const TOther&) const
-      -> const type_<TOther> {
-    return {};
+  /// @return nullopt if there is no such file
+  [[nodiscard]] static auto stat(const std::string& file)
+      -> std::optional<status> {
+#if __has_include(<sys/stat.h>)
+    struct ::stat st{};
+    if (::stat(file.c_str(), &st)) {
+      return std::nullopt;
+    }
+    auto modified = static_cast<std::int64_t>(st.st_mtime) * 1'000'000'000;
+#if defined(__linux__)
+    modified += st.st_mtim.tv_nsec;
+#endif
+    return status{.size = static_cast<std::uintmax_t>(st.st_size),
+                  .modified = modified,
+                  .regular = (st.st_mode & S_IFMT) == S_IFREG};
+#else
+    void(file);
+    return std::nullopt;
+#endif
   }
-  [[nodiscard]] constexpr auto operator==(type_<T>) -> bool { return true; }
-  template <class TOther>
-  [[nodiscard]] constexpr auto operator==(type_<TOther>) -> bool {
-    return false;
+
+  /// @return nullopt if the file cannot be read
+  [[nodiscard]] static auto read(const std::string& file)
+      -> std::optional<std::string> {
+    auto* const in = file.empty() ? nullptr : std::fopen(file.c_str(), "rb");
+    if (not in) {
+      return std::nullopt;
+    }
+    auto text = std::string{};
+    char buffer[4096];
+    for (std::size_t n{}; (n = std::fread(buffer, 1, sizeof(buffer), in));) {
+      text.append(buffer, n);
+    }
+    std::fclose(in);
+    return text;
   }
-  template <class TOther>
-  [[nodiscard]] constexpr auto operator==(const TOther&) -> bool {
-    return std::is_same_v<TOther, T>;
+
+  static auto write(const std::string& file, const std::string& text)
+      -> void {
+    if (auto* const out = std::fopen(file.c_str(), "wb")) {
+      std::fwrite(text.data(), 1, text.size(), out);
+      std::fclose(out);
+    }
   }
-  [[nodiscard]] constexpr auto operator!=(type_<T>) -> bool { return false; }
-  template <class TOther>
-  [[nodiscard]] constexpr auto operator!=(type_<TOther>) -> bool {
-    return true;
+
+#if defined(BOOST_UT_RUN_TOOLS)
+  /// names in a directory, empty if it cannot be read
+  [[nodiscard]] static auto list(const std::string& directory)
+      -> std::vector<std::string> {
+    auto names = std::vector<std::string>{};
+#if __has_include(<dirent.h>) and __has_include(<unistd.h>)
+    if (auto* const dir = ::opendir(directory.c_str())) {
+      while (const auto* const entry = ::readdir(dir)) {
+        if (const auto name = std::string_view{entry->d_name};
+            name != "." and name != "..") {
+          names.emplace_back(name);
+        }
+      }
+      ::closedir(dir);
+    }
+#else
+    void(directory);
+#endif
+    return names;
   }
-  template <class TOther>
-  [[nodiscard]] constexpr auto operator!=(const TOther&) -> bool {
-    return not std::is_same_v<TOther, T>;
+
+  /// target of a symbolic link, empty if it is none
+  [[nodiscard]] static auto read_link(const std::string& link) -> std::string {
+#if __has_include(<dirent.h>) and __has_include(<unistd.h>)
+    char target[4096];
+    if (const auto n = ::readlink(link.c_str(), target, sizeof(target));
+        n > 0) {
+      return std::string(target, static_cast<std::size_t>(n));
+    }
+#else
+    void(link);
+#endif
+    return {};
   }
+#endif
 };
 
-template <class T, class = int>
-struct value : op {
-  using value_type = T;
+/// Set of test paths, i.e. names of the enclosing tests down to the test.
+/// A test matches when it lies on the way to, or below, one of the paths.
+class test_paths {
+ public:
+  using path = std::vector<std::string>;
 
-  constexpr /*explicit(false)*/ value(const T& _value) : value_{_value} {}
-  [[nodiscard]] constexpr explicit operator T() const { return value_; }
-  [[nodiscard]] constexpr decltype(auto) get() const { return value_; }
+  auto insert(path p) -> void {
+    if (std::find(paths_.cbegin(), paths_.cend(), p) == paths_.cend()) {
+      paths_.push_back(std::move(p));
+    }
+  }
 
-  T value_{};
-};
+  template <class TPath>
+  [[nodiscard]] auto matches(const std::size_t level, const TPath& p) const
+      -> bool {
+    return std::any_of(paths_.cbegin(), paths_.cend(), [&](const auto& e) {
+      for (auto i = 0u; i < std::min(level + 1, std::size(e)); ++i) {
+        if (e[i] != p[i]) {
+          return false;
+        }
+      }
+      return true;
+    });
+  }
 
-template <std::floating_point T>
-struct value<T> : op {
-  using value_type = T;
-  static inline auto epsilon = T{};
+  [[nodiscard]] auto empty() const { return paths_.empty(); }
+  [[nodiscard]] auto size() const { return paths_.size(); }
+  [[nodiscard]] auto begin() const { return paths_.cbegin(); }
+  [[nodiscard]] auto end() const { return paths_.cend(); }
 
-  constexpr value(const T& _value, const T precision) : value_{_value} {
-    epsilon = precision;
+  /// one path per line, names separated by tabs
+  [[nodiscard]] static auto to_line(const path& p) -> std::string {
+    auto line = std::string{};
+    for (const auto& name : p) {
+      line += (line.empty() ? "" : "\t") + name;
+    }
+    return line;
   }
 
-  constexpr /*explicit(false)*/ value(const T& val)
-      : value{val, T(1) / math::pow(T(10),
-                                    math::den_size<unsigned long long>(val))} {}
-  [[nodiscard]] constexpr explicit operator T() const { return value_; }
-  [[nodiscard]] constexpr decltype(auto) get() const { return value_; }
+  [[nodiscard]] static auto from_line(std::string_view line) -> path {
+    auto p = path{};
+    for (const auto name : utility::split(line, "\t")) {
+      p.emplace_back(name);
+    }
+    return p;
+  }
 
-  T value_{};
+ private:
+  std::vector<path> paths_{};
 };
 
-template <class T>
-class value_location : public detail::value<T> {
+/// Failing tests of a run, persisted so that the next run can be limited
+/// to them (--last-failed). A top-level test which runs again replaces its
+/// previously recorded failures, the others are carried over.
+class run_state {
+  static constexpr auto header = std::string_view{"ut-state 1 "};
+
  public:
-  constexpr /*explicit(false)*/ value_location(
-      const T& t, const reflection::source_location& sl =
-                      reflection::source_location::current())
-      : detail::value<T>{t} {
-    cfg::location = sl;
+  /// identifies the test executable which wrote the state
+  [[nodiscard]] static auto current_build_id() -> std::string {
+    const auto executable = files::stat(cfg::executable_name);
+    if (not executable) {
+      return "unknown";
+    }
+    return std::to_string(executable->size) + '-' +
+           std::to_string(executable->modified);
   }
 
-  constexpr value_location(const T& t, const T precision,
-                           const reflection::source_location& sl =
-                               reflection::source_location::current())
-      : detail::value<T>{t, precision} {
-    cfg::location = sl;
+  /// @return false if there is no (valid) state file
+  auto load(const std::string& file) -> bool {
+    const auto text = files::read(file);
+    if (not text or not text->starts_with(header)) {
+      return false;
+    }
+    const auto lines = utility::split(std::string_view{*text}, "\n");
+    build_id_ = lines.front().substr(header.size());
+    for (auto line = lines.cbegin() + 1; line != lines.cend(); ++line) {
+      if (not line->empty()) {
+        previous_.insert(test_paths::from_line(*line));
+      }
+    }
+    return true;
   }
-};
-
-template <auto N>
-struct integral_constant : op {
-  using value_type = decltype(N);
-  static constexpr auto value = N;
 
-  [[nodiscard]] constexpr auto operator-() const {
-    return integral_constant<-N>{};
+  auto save(const std::string& file) const -> void {
+    if (file.empty()) {
+      return;
+    }
+    auto text = std::string{header} + current_build_id() + '\n';
+    for (const auto& p : previous_) {
+      if (std::find(ran_.cbegin(), ran_.cend(), p.front()) == ran_.cend()) {
+        text += test_paths::to_line(p) + '\n';
+      }
+    }
+    for (const auto& p : failed_) {
+      text += test_paths::to_line(p) + '\n';
+    }
+    files::write(file, text);
   }
-  [[nodiscard]] constexpr explicit operator value_type() const { return N; }
-  [[nodiscard]] constexpr auto get() const { return N; }
-};
-
-template <class T, auto N, auto D, auto Size, auto P = 1>
-struct floating_point_constant : op {
-  using value_type = T;
 
-  static constexpr auto epsilon = T(1) / math::pow(T(10), Size - 1);
-  static constexpr auto value = T(P) * (T(N) + (T(D) / math::pow(T(10), Size)));
+  auto ran(std::string_view name) -> void { ran_.emplace_back(name); }
+  auto failed(test_paths::path p) -> void { failed_.insert(std::move(p)); }
 
-  [[nodiscard]] constexpr auto operator-() const {
-    return floating_point_constant<T, N, D, Size, -1>{};
+  [[nodiscard]] auto previous() const -> const test_paths& { return previous_; }
+  [[nodiscard]] auto build_id() const -> const std::string& {
+    return build_id_;
   }
-  [[nodiscard]] constexpr explicit operator value_type() const { return value; }
-  [[nodiscard]] constexpr auto get() const { return value; }
-};
 
-template <class TLhs, class TRhs>
-struct eq_ : op {
-  constexpr eq_(const TLhs& lhs = {}, const TRhs& rhs = {})
-      : lhs_{lhs}, rhs_{rhs}, value_{[&] {
-          using std::operator==;
-          using std::operator<;
+ private:
+  std::string build_id_{};
+  test_paths previous_{};
+  test_paths failed_{};
+  std::vector<std::string> ran_{};
+};
 
-          if constexpr (type_traits::has_static_member_object_value_v<TLhs> and
-                        type_traits::has_static_member_object_value_v<TRhs>) {
-            return lhs.value == rhs.value;
-          } else if constexpr (type_traits::has_static_member_object_epsilon_v<
-                                   TLhs> and
-                               type_traits::has_static_member_object_epsilon_v<
-                                   TRhs>) {
-            return math::abs(get(lhs) - get(rhs)) <
-                   math::min_value(TLhs::epsilon, TRhs::epsilon);
-          } else if constexpr (type_traits::has_static_member_object_epsilon_v<
-                                   TLhs>) {
-            return math::abs(get(lhs) - get(rhs)) < TLhs::epsilon;
-          } else if constexpr (type_traits::has_static_member_object_epsilon_v<
-                                   TRhs>) {
-            return math::abs(get(lhs) - get(rhs)) < TRhs::epsilon;
-          } else {
-            return get(lhs) == get(rhs);
-          }
-        }()} {}
+#if defined(BOOST_UT_RUN_TOOLS)
+/// e.g. "2h", "30m", "45s" or "500ms" (seconds without a unit), zero when it
+/// cannot be parsed
+[[nodiscard]] inline auto parse_duration(std::string_view text)
+    -> std::chrono::steady_clock::duration {
+  auto value = 0.0;
+  const auto [unit, ec] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  const auto suffix = std::string_view{unit, text.data() + text.size()};
+  auto seconds = -1.0;
+  if (suffix == "ms") {
+    seconds = value / 1000;
+  } else if (suffix.empty() or suffix == "s") {
+    seconds = value;
+  } else if (suffix == "m") {
+    seconds = value * 60;
+  } else if (suffix == "h") {
+    seconds = value * 3600;
+  }
+  if (ec != std::errc{} or seconds <= 0) {
+    return {};
+  }
+  return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(seconds));
+}
 
-  [[nodiscard]] constexpr operator bool() const { return value_; }
-  [[nodiscard]] constexpr auto lhs() const { return get(lhs_); }
-  [[nodiscard]] constexpr auto rhs() const { return get(rhs_); }
+/// Durations and outcomes of the tests in the previous runs, appended to a
+/// file (`<microseconds>\t<pass|fail>\t<path>` lines, see test_paths) at the
+/// end of a run, to flag the tests which got much slower than they used to
+/// be and to pick the tests of a --time-budget. Only the last `window` runs
+/// of a test are kept (and the file compacted when it is twice as long).
+/// Writers lock the file, so concurrently running shards may share it.
+class durations {
+  static constexpr auto header = std::string_view{"ut-durations 3"};
 
-  const TLhs lhs_{};
-  const TRhs rhs_{};
-  const bool value_{};
-};
+ public:
+  using duration = std::chrono::microseconds;
+  static constexpr std::size_t window = 20;
+  static constexpr std::size_t min_history = 5;
+  static constexpr double max_deviations = 3;  // median absolute deviations
+  static constexpr auto min_slowdown = std::chrono::milliseconds{50};
+
+  struct run {
+    duration took{};
+    bool passed{};
+  };
+  using history_t = std::unordered_map<std::string, std::deque<run>>;
 
-template <class TLhs, class TRhs, class TEpsilon>
-struct approx_ : op {
-  constexpr approx_(const TLhs& lhs = {}, const TRhs& rhs = {},
-                    const TEpsilon& epsilon = {})
-      : lhs_{lhs}, rhs_{rhs}, epsilon_{epsilon}, value_{[&] {
-          using std::operator<;
+  auto load(const std::string& file) -> void {
+    file_ = file;
+    if (not file.empty()) {
+      auto in = std::ifstream{file};
+      read(in);
+    }
+  }
 
-          if constexpr (type_traits::has_static_member_object_value_v<TLhs> and
-                        type_traits::has_static_member_object_value_v<TRhs> and
-                        type_traits::has_static_member_object_value_v<
-                            TEpsilon>) {
-            return math::abs_diff(TLhs::value, TRhs::value) < TEpsilon::value;
-          } else {
-            return math::abs_diff(get(lhs), get(rhs)) < get(epsilon);
-          }
-        }()} {}
+  /// e.g. "took 20013ms, usually 51ms", empty unless `took` is more than
+  /// `max_deviations` median absolute deviations, and `min_slowdown`, over
+  /// the median of the previous durations of the test (when it passed)
+  [[nodiscard]] auto slowdown(const std::string& name,
+                              const duration took) const -> std::string {
+    auto passed = std::vector<duration>{};
+    if (const auto history = history_.find(name); history != history_.cend()) {
+      for (const auto& r : history->second) {
+        if (r.passed) {
+          passed.push_back(r.took);
+        }
+      }
+    }
+    if (passed.size() < min_history) {
+      return {};
+    }
+    const auto usual = median(passed);
+    auto deviations = std::vector<duration>{};
+    for (const auto d : passed) {
+      deviations.push_back(d > usual ? d - usual : usual - d);
+    }
+    const auto deviation = median(std::move(deviations));
+    if (took - usual <= min_slowdown or
+        static_cast<double>((took - usual).count()) <=
+            max_deviations * static_cast<double>(deviation.count())) {
+      return {};
+    }
+    const auto ms = [](const duration d) {
+      return std::to_string(
+                 std::chrono::duration_cast<std::chrono::milliseconds>(d)
+                     .count()) +
+             "ms";
+    };
+    return "took " + ms(took) + ", usually " + ms(usual) + " (median of " +
+           std::to_string(passed.size()) + " runs)";
+  }
 
-  [[nodiscard]] constexpr operator bool() const { return value_; }
-  [[nodiscard]] constexpr auto lhs() const { return get(lhs_); }
-  [[nodiscard]] constexpr auto rhs() const { return get(rhs_); }
-  [[nodiscard]] constexpr auto epsilon() const { return get(epsilon_); }
+  [[nodiscard]] static auto median(std::vector<duration> values) -> duration {
+    if (values.empty()) {
+      return {};
+    }
+    const auto middle = values.begin() + values.size() / 2;
+    std::nth_element(values.begin(), middle, values.end());
+    return *middle;
+  }
 
-  const TLhs lhs_{};
-  const TRhs rhs_{};
-  const TEpsilon epsilon_{};
-  const bool value_{};
-};
+  [[nodiscard]] auto history() const -> const history_t& { return history_; }
+  [[nodiscard]] auto file() const -> const std::string& { return file_; }
 
-template <class TLhs, class TRhs>
-struct neq_ : op {
-  constexpr neq_(const TLhs& lhs = {}, const TRhs& rhs = {})
-      : lhs_{lhs}, rhs_{rhs}, value_{[&] {
-          using std::operator==;
-          using std::operator!=;
-          using std::operator>;
+  auto append(const std::string& name, const run& r) -> void {
+    appended_.emplace_back(name, r);
+  }
 
-          if constexpr (type_traits::has_static_member_object_value_v<TLhs> and
-                        type_traits::has_static_member_object_value_v<TRhs>) {
-            return lhs.value != rhs.value;
-          } else if constexpr (type_traits::has_static_member_object_epsilon_v<
-                                   TLhs> and
-                               type_traits::has_static_member_object_epsilon_v<
-                                   TRhs>) {
-            return math::abs(get(lhs_) - get(rhs_)) >
-                   math::min_value(TLhs::epsilon, TRhs::epsilon);
-          } else if constexpr (type_traits::has_static_member_object_epsilon_v<
-                                   TLhs>) {
-            return math::abs(get(lhs_) - get(rhs_)) > TLhs::epsilon;
-          } else if constexpr (type_traits::has_static_member_object_epsilon_v<
-                                   TRhs>) {
-            return math::abs(get(lhs_) - get(rhs_)) > TRhs::epsilon;
-          } else {
-            return get(lhs_) != get(rhs_);
-          }
-        }()} {}
+  /// appends the runs of this run in a single write, or rewrites the file
+  /// with the last `window` runs of every test
+  auto save() -> void {
+    if (file_.empty() or appended_.empty()) {
+      return;
+    }
+#if __has_include(<unistd.h>) and __has_include(<sys/wait.h>)
+    const auto fd = ::open(file_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+      return;
+    }
+    struct flock lock {};
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    while (::fcntl(fd, F_SETLKW, &lock) != 0 and errno == EINTR) {
+    }
+    auto content = std::string{};
+    char buffer[4096];
+    for (auto n = ::read(fd, buffer, sizeof(buffer)); n > 0;
+         n = ::read(fd, buffer, sizeof(buffer))) {
+      content.append(buffer, static_cast<std::size_t>(n));
+    }
+    auto in = std::istringstream{content};
+#else
+    auto in = std::ifstream{file_};
+#endif
+    // runs appended by others since load() are only known to the file
+    auto current = durations{};
+    const auto compact = not current.read(in) or
+                         current.lines_ > 2 * window * current.history_.size();
+    auto lines = std::string{};
+    const auto write = [&](const std::string& name, const run& r) {
+      lines += std::to_string(r.took.count()) +
+               (r.passed ? "\tpass\t" : "\tfail\t") + name + '\n';
+    };
+    if (compact) {
+      for (const auto& [name, r] : appended_) {
+        current.add(name, r);
+      }
+      lines = std::string{header} + '\n';
+      for (const auto& [name, runs] : current.history_) {
+        for (const auto& r : runs) {
+          write(name, r);
+        }
+      }
+    } else {
+      for (const auto& [name, r] : appended_) {
+        write(name, r);
+      }
+    }
+#if __has_include(<unistd.h>) and __has_include(<sys/wait.h>)
+    if (compact and ::ftruncate(fd, 0) != 0) {
+      ::close(fd);
+      return;
+    }
+    ::lseek(fd, 0, compact ? SEEK_SET : SEEK_END);
+    for (auto written = std::size_t{}; written < lines.size();) {
+      const auto n =
+          ::write(fd, lines.data() + written, lines.size() - written);
+      if (n < 0 and errno != EINTR) {
+        break;
+      }
+      written += static_cast<std::size_t>(std::max<decltype(n)>(n, 0));
+    }
+    ::close(fd);  // releases the lock
+#else
+    std::ofstream{file_, compact ? std::ios::trunc : std::ios::app} << lines;
+#endif
+    appended_.clear();
+  }
 
-  [[nodiscard]] constexpr operator bool() const { return value_; }
-  [[nodiscard]] constexpr auto lhs() const { return get(lhs_); }
-  [[nodiscard]] constexpr auto rhs() const { return get(rhs_); }
+ private:
+  /// @return false if `in` isn't a durations file
+  auto read(std::istream& in) -> bool {
+    auto line = std::string{};
+    if (not std::getline(in, line) or line != header) {
+      return false;
+    }
+    while (std::getline(in, line)) {
+      auto us = duration::rep{};
+      const auto outcome = line.find('\t');
+      const auto name = line.find('\t', outcome + 1);
+      if (outcome == std::string::npos or name == std::string::npos or
+          std::from_chars(line.data(), line.data() + outcome, us).ec !=
+              std::errc{}) {
+        continue;
+      }
+      ++lines_;
+      add(line.substr(name + 1),
+          {duration{us},
+           line.compare(outcome + 1, name - outcome - 1, "pass") == 0});
+    }
+    return true;
+  }
 
-  const TLhs lhs_{};
-  const TRhs rhs_{};
-  const bool value_{};
+  auto add(const std::string& name, const run& r) -> void {
+    auto& runs = history_[name];
+    runs.push_back(r);
+    if (runs.size() > window) {
+      runs.pop_front();
+    }
+  }
+
+  std::string file_{};
+  std::size_t lines_{};
+  history_t history_{};
+  std::vector<std::pair<std::string, run>> appended_{};
 };
 
-template <class TLhs, class TRhs>
-struct gt_ : op {
-  constexpr gt_(const TLhs& lhs = {}, const TRhs& rhs = {})
-      : lhs_{lhs}, rhs_{rhs}, value_{[&] {
-          using std::operator>;
+/// Top-level tests of a run with a deadline (--time-budget). The tests
+/// known from the durations file are picked by their chance to fail (their
+/// failures in the last runs, smoothed) per second of their usual duration,
+/// as long as their durations fit in the budget. New tests and tests
+/// declared in files changed since the last run are always picked. The
+/// picked tests still run in declaration order, and those which would not
+/// finish before the deadline are skipped too.
+class time_budget {
+ public:
+  using clock = std::chrono::steady_clock;
+  static constexpr auto min_duration = std::chrono::milliseconds{1};
 
-          if constexpr (type_traits::has_static_member_object_value_v<TLhs> and
-                        type_traits::has_static_member_object_value_v<TRhs>) {
-            return lhs.value > rhs.value;
-          } else {
-            return get(lhs_) > get(rhs_);
-          }
-        }()} {}
+  time_budget() = default;
+  time_budget(const time_budget&) = delete;
+  time_budget& operator=(const time_budget&) = delete;
+  ~time_budget() {
+    {
+      const auto lock = std::scoped_lock{mutex_};
+      stopped_ = true;
+    }
+    wake_.notify_all();
+    if (watchdog_.joinable()) {
+      watchdog_.join();
+    }
+  }
 
-  [[nodiscard]] constexpr operator bool() const { return value_; }
-  [[nodiscard]] constexpr auto lhs() const { return get(lhs_); }
-  [[nodiscard]] constexpr auto rhs() const { return get(rhs_); }
+  [[nodiscard]] explicit operator bool() const { return budget_.count(); }
 
-  const TLhs lhs_{};
-  const TRhs rhs_{};
-  const bool value_{};
-};
+  auto start(const clock::duration budget, const durations& history) -> void {
+    budget_ = budget;
+    deadline_ = clock::now() + budget;
+    const auto last_run = files::stat(history.file());
+    last_run_ = last_run ? last_run->modified : 0;
+    struct candidate {
+      const std::string* name{};
+      durations::duration took{};
+      double density{};
+    };
+    auto candidates = std::vector<candidate>{};
+    auto usuals = std::vector<durations::duration>{};
+    for (const auto& [name, runs] : history.history()) {
+      if (name.find('\t') != std::string::npos) {
+        continue;  // nested
+      }
+      auto took = std::vector<durations::duration>{};
+      auto failures = 0.0;
+      for (const auto& r : runs) {
+        took.push_back(r.took);
+        failures += not r.passed;
+      }
+      const auto usual = std::max<durations::duration>(
+          durations::median(std::move(took)), min_duration);
+      estimates_[name] = usual;
+      usuals.push_back(usual);
+      const auto chance =
+          (failures + 1) / (static_cast<double>(runs.size()) + 2);
+      candidates.push_back(
+          {&name, usual,
+           chance / std::chrono::duration<double>(usual).count()});
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const auto& lhs, const auto& rhs) {
+                       return lhs.density > rhs.density;
+                     });
+    if (not usuals.empty()) {
+      unknown_ = durations::median(std::move(usuals));
+    }
+    for (const auto& c : candidates) {
+      if (pending_ + c.took <= budget) {
+        pending_ += c.took;
+        picked_.insert(*c.name);
+        plan_.emplace_back(*c.name, c.took);
+      }
+    }
+  }
 
-template <class TLhs, class TRhs>
-struct ge_ : op {
-  constexpr ge_(const TLhs& lhs = {}, const TRhs& rhs = {})
-      : lhs_{lhs}, rhs_{rhs}, value_{[&] {
-          using std::operator>=;
+  /// whether to run the top-level test `name`, declared in `file`. New tests
+  /// and those of changed files are run if they fit (estimating new ones by
+  /// the median test), displacing the least likely picked ones not run yet
+  [[nodiscard]] auto admit(const std::string_view name, const char* file)
+      -> bool {
+    const auto key = std::string{name};
+    const auto known = estimates_.find(key);
+    const auto estimate =
+        known == estimates_.cend() ? unknown_ : known->second;
+    const auto picked = picked_.erase(key) > 0;
+    if (picked) {
+      pending_ -= estimate;
+    }
+    const auto* reason = static_cast<const char*>(nullptr);
+    if (not picked and known != estimates_.cend() and not changed(file)) {
+      reason = displaced_.contains(key) ? "displaced by new or changed tests"
+                                        : "not picked";
+    } else if (clock::now() + estimate > deadline_) {
+      reason = "would not finish before the deadline";
+    } else if (not picked) {
+      make_room(estimate);
+    }
+    if (reason) {
+      skipped_.emplace_back(key, reason);
+      return false;
+    }
+    ++ran_;
+    running_ = true;
+    return true;
+  }
 
-          if constexpr (type_traits::has_static_member_object_value_v<TLhs> and
-                        type_traits::has_static_member_object_value_v<TRhs>) {
-            return lhs.value >= rhs.value;
-          } else {
-            return get(lhs_) >= get(rhs_);
-          }
-        }()} {}
+  /// the admitted test finished
+  auto finished() -> void { running_ = false; }
 
-  [[nodiscard]] constexpr operator bool() const { return value_; }
-  [[nodiscard]] constexpr auto lhs() const { return get(lhs_); }
-  [[nodiscard]] constexpr auto rhs() const { return get(rhs_); }
+  /// calls `expired` on a thread of its own if a test is still running at
+  /// the deadline
+  template <class F>
+  auto watch(F expired) -> void {
+    watchdog_ = std::thread{[this, expired] {
+      auto lock = std::unique_lock{mutex_};
+      if (not wake_.wait_until(lock, deadline_, [this] { return stopped_; }) and
+          running_) {
+        lock.unlock();
+        expired();
+      }
+    }};
+  }
+
+  /// e.g. "time budget of 90.0s: ran 42 tests in 61.3s, skipped 3" followed
+  /// by the skipped tests
+  auto report(std::ostream& os) const -> void {
+    const auto seconds = [](const clock::duration d) {
+      const auto tenths =
+          std::chrono::duration_cast<std::chrono::milliseconds>(d).count() /
+          100;
+      return std::to_string(tenths / 10) + '.' + std::to_string(tenths % 10) +
+             's';
+    };
+    os << "time budget of " << seconds(budget_) << ": ran " << ran_
+       << " tests in " << seconds(clock::now() - (deadline_ - budget_))
+       << ", skipped " << skipped_.size() << '\n';
+    for (const auto& [name, reason] : skipped_) {
+      os << "  " << name << " (" << reason << ")\n";
+    }
+  }
 
-  const TLhs lhs_{};
-  const TRhs rhs_{};
-  const bool value_{};
+ private:
+  /// displaces picked tests, the least likely to fail first, until the ones
+  /// left and a test taking `estimate` fit before the deadline
+  auto make_room(const durations::duration estimate) -> void {
+    while (not plan_.empty() and
+           clock::now() + pending_ + estimate > deadline_) {
+      if (picked_.erase(plan_.back().first)) {
+        pending_ -= plan_.back().second;
+        displaced_.insert(plan_.back().first);
+      }
+      plan_.pop_back();
+    }
+  }
+
+  [[nodiscard]] auto changed(const char* file) -> bool {
+    if (not file or not *file) {
+      return false;
+    }
+    const auto [modified, inserted] = changed_.try_emplace(file);
+    if (inserted) {
+      const auto source = files::stat(file);
+      modified->second = source and source->modified > last_run_;
+    }
+    return modified->second;
+  }
+
+  clock::duration budget_{};
+  clock::time_point deadline_{};
+  std::int64_t last_run_{};  // ns since the epoch
+  std::unordered_map<std::string, durations::duration> estimates_{};
+  durations::duration unknown_{min_duration};  // estimate of new tests
+  std::set<std::string> picked_{};  // not run yet
+  std::vector<std::pair<std::string, durations::duration>> plan_{};
+  clock::duration pending_{};  // of the picked tests
+  std::set<std::string> displaced_{};
+  std::unordered_map<std::string, bool> changed_{};  // by file
+  std::size_t ran_{};
+  std::vector<std::pair<std::string, const char*>> skipped_{};
+  std::atomic<bool> running_{};
+  std::mutex mutex_{};
+  std::condition_variable wake_{};
+  bool stopped_{};
+  std::thread watchdog_{};
 };
 
-template <class TLhs, class TRhs>
-struct lt_ : op {
-  constexpr lt_(const TLhs& lhs = {}, const TRhs& rhs = {})
-      : lhs_{lhs}, rhs_{rhs}, value_{[&] {
-          using std::operator<;
+#if __has_include(<unistd.h>) and __has_include(<sys/wait.h>)
+/// calls the handler of the running runner on SIGINT/SIGTERM. The signal
+/// handler only wakes a thread via a pipe (async-signal-safe), the runner
+/// then reports in between its events.
+class interrupts {
+ public:
+  using handler = void (*)(void*, int);
 
-          if constexpr (type_traits::has_static_member_object_value_v<TLhs> and
-                        type_traits::has_static_member_object_value_v<TRhs>) {
-#if defined(_MSC_VER) && !defined(__clang__)
-            // for some reason, accessing the static member via :: does not compile on MSVC,
-            // and the next line does not compile on clang, so we have to use the ifdef here
-            return lhs.value < rhs.value;
-#else
-            return TLhs::value < TRhs::value;
-#endif
-          } else {
-            return get(lhs_) < get(rhs_);
-          }
-        }()} {
+  static auto handle(void* runner, const handler on_interrupt) -> void {
+    const auto lock = std::scoped_lock{mutex_};
+    runner_ = runner;
+    handler_ = on_interrupt;
+    if (pid_ == getpid()) {
+      return;
+    }
+    int fds[2]{};
+    if (pipe(fds)) {
+      return;
+    }
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    fd_ = fds[1];
+    if (not std::exchange(installed_, true)) {  // inherited by forks
+      struct sigaction action{};
+      action.sa_handler = &on_signal;
+      sigemptyset(&action.sa_mask);
+      action.sa_flags = SA_RESTART;
+      for (const auto sig : {SIGINT, SIGTERM}) {
+        struct sigaction previous{};
+        if (not sigaction(sig, nullptr, &previous) and
+            previous.sa_handler == SIG_DFL) {  // keeps handlers of the tests
+          sigaction(sig, &action, nullptr);
+        }
+      }
+    }
+    pid_ = getpid();
+    std::thread{[fd = fds[0]] {
+      char sig{};
+      while (read(fd, &sig, 1) < 0 and errno == EINTR) {
+      }
+      if (const auto interrupt_lock = std::scoped_lock{mutex_}; runner_) {
+        handler_(runner_, sig);
+      }
+      signal(sig, SIG_DFL);  // the run is already over
+      raise(sig);
+    }}.detach();
   }
 
-  [[nodiscard]] constexpr operator bool() const { return value_; }
-  [[nodiscard]] constexpr auto lhs() const { return get(lhs_); }
-  [[nodiscard]] constexpr auto rhs() const { return get(rhs_); }
+  static auto release(void* runner) -> void {
+    const auto lock = std::scoped_lock{mutex_};
+    if (runner_ == runner) {
+      runner_ = {};
+    }
+  }
 
  private:
-  const TLhs lhs_{};
-  const TRhs rhs_{};
-  const bool value_{};
+  static auto on_signal(const int sig) -> void {
+    if (pid_ != getpid()) {  // forked child without a runner
+      signal(sig, SIG_DFL);
+      raise(sig);
+      return;
+    }
+    const auto error = errno;
+    const auto byte = static_cast<char>(sig);
+    static_cast<void>(::write(fd_, &byte, 1));
+    errno = error;
+  }
+
+  static inline std::mutex mutex_{};
+  static inline void* runner_{};
+  static inline handler handler_{};
+  static inline bool installed_{};
+  static inline std::atomic<pid_t> pid_{};
+  static inline std::atomic<int> fd_{-1};
 };
+#endif
 
-template <class TLhs, class TRhs>
-struct le_ : op {
-  constexpr le_(const TLhs& lhs = {}, const TRhs& rhs = {})
-      : lhs_{lhs}, rhs_{rhs}, value_{[&] {
-          using std::operator<=;
+/// append-only log of the completed top-level tests which survives a crash
+/// (or kill) of the run, one `<worker>\t<pass|fail>\t<name>` line per test
+class journal {
+  static constexpr auto header = std::string_view{"ut-journal 2"};
+  static constexpr auto sync_after = 32u;  // tests
+  static constexpr auto sync_every = std::chrono::seconds{1};
 
-          if constexpr (type_traits::has_static_member_object_value_v<TLhs> and
-                        type_traits::has_static_member_object_value_v<TRhs>) {
-            return lhs.value <= rhs.value;
-          } else {
-            return get(lhs_) <= get(rhs_);
-          }
-        }()} {}
+ public:
+  struct entry {
+    std::size_t worker{};
+    bool passed{};
+    std::size_t ordinal{};  // of the top-level test, in declaration order
+    std::string name{};
+  };
 
-  [[nodiscard]] constexpr operator bool() const { return value_; }
-  [[nodiscard]] constexpr auto lhs() const { return get(lhs_); }
-  [[nodiscard]] constexpr auto rhs() const { return get(rhs_); }
+  journal() = default;
+  journal(const journal&) = delete;
+  journal& operator=(const journal&) = delete;
+  ~journal() { close(); }
+
+  [[nodiscard]] static auto load(const std::string& file) -> std::vector<entry> {
+    auto entries = std::vector<entry>{};
+    auto in = std::ifstream{file};
+    auto line = std::string{};
+    if (not std::getline(in, line) or line != header) {
+      return entries;
+    }
+    while (std::getline(in, line)) {
+      const auto worker = line.find('\t');
+      const auto outcome = line.find('\t', worker + 1);
+      const auto ordinal = line.find('\t', outcome + 1);
+      if (in.eof() or worker == std::string::npos or
+          outcome == std::string::npos or ordinal == std::string::npos) {
+        continue;  // torn by a crash
+      }
+      auto e = entry{
+          .passed = line.compare(worker + 1, outcome - worker - 1, "pass") == 0,
+          .name = line.substr(ordinal + 1)};
+      std::from_chars(line.data(), line.data() + worker, e.worker);
+      std::from_chars(line.data() + outcome + 1, line.data() + ordinal,
+                      e.ordinal);
+      entries.push_back(std::move(e));
+    }
+    return entries;
+  }
 
-  const TLhs lhs_{};
-  const TRhs rhs_{};
-  const bool value_{};
-};
+  /// @param append continue an existing journal instead of starting a new one
+  auto open(const std::string& file, const bool append) -> void {
+    const auto exists = append and files::stat(file).has_value();
+#if __has_include(<unistd.h>) and __has_include(<sys/wait.h>)
+    fd_ = ::open(file.c_str(),
+                 O_WRONLY | O_CREAT | O_CLOEXEC | (exists ? O_APPEND : O_TRUNC),
+                 0644);
+#else
+    out_.open(file, exists ? std::ios::app : std::ios::trunc);
+#endif
+    if (not exists) {
+      write(std::string{header} + '\n');
+    } else if (auto in = std::ifstream{file, std::ios::ate};
+               in.tellg() > 0 and in.seekg(-1, std::ios::end).get() != '\n') {
+      write("\n");  // terminates a line torn by a crash
+    }
+  }
 
-template <class TLhs, class TRhs>
-struct and_ : op {
-  constexpr and_(const TLhs& lhs = {}, const TRhs& rhs = {})
-      : lhs_{lhs},
-        rhs_{rhs},
-        value_{static_cast<bool>(lhs) and static_cast<bool>(rhs)} {}
+  auto append(const entry& e) -> void {
+    write(std::to_string(e.worker) + (e.passed ? "\tpass\t" : "\tfail\t") +
+          std::to_string(e.ordinal) + '\t' + e.name + '\n');
+    if (++pending_ >= sync_after or
+        std::chrono::steady_clock::now() - synced_ >= sync_every) {
+      sync();
+    }
+  }
 
-  [[nodiscard]] constexpr operator bool() const { return value_; }
-  [[nodiscard]] constexpr auto lhs() const { return get(lhs_); }
-  [[nodiscard]] constexpr auto rhs() const { return get(rhs_); }
+  /// makes the appended entries durable
+  auto sync() -> void {
+#if __has_include(<unistd.h>) and __has_include(<sys/wait.h>)
+    if (fd_ >= 0 and pending_) {
+      static_cast<void>(::fsync(fd_));
+    }
+#endif
+    pending_ = {};
+    synced_ = std::chrono::steady_clock::now();
+  }
 
-  const TLhs lhs_{};
-  const TRhs rhs_{};
-  const bool value_{};
-};
+  auto close() -> void {
+    sync();
+#if __has_include(<unistd.h>) and __has_include(<sys/wait.h>)
+    if (fd_ >= 0) {
+      ::close(std::exchange(fd_, -1));
+    }
+#else
+    out_.close();
+#endif
+  }
 
-template <class TLhs, class TRhs>
-struct or_ : op {
-  constexpr or_(const TLhs& lhs = {}, const TRhs& rhs = {})
-      : lhs_{lhs},
-        rhs_{rhs},
-        value_{static_cast<bool>(lhs) or static_cast<bool>(rhs)} {}
+  [[nodiscard]] explicit operator bool() const {
+#if __has_include(<unistd.h>) and __has_include(<sys/wait.h>)
+    return fd_ >= 0;
+#else
+    return out_.is_open();
+#endif
+  }
 
-  [[nodiscard]] constexpr operator bool() const { return value_; }
-  [[nodiscard]] constexpr auto lhs() const { return get(lhs_); }
-  [[nodiscard]] constexpr auto rhs() const { return get(rhs_); }
+  /// index of the calling thread, in the order threads completed tests
+  [[nodiscard]] static auto worker() -> std::size_t {
+    static std::atomic<std::size_t> workers{};
+    thread_local const auto id = workers++;
+    return id;
+  }
 
-  const TLhs lhs_{};
-  const TRhs rhs_{};
-  const bool value_{};
+ private:
+  auto write(const std::string& line) -> void {
+#if __has_include(<unistd.h>) and __has_include(<sys/wait.h>)
+    // a single write per line, completed lines are kept if the process dies
+    static_cast<void>(::write(fd_, line.data(), line.size()));
+#else
+    out_ << line << std::flush;
+#endif
+  }
+
+#if __has_include(<unistd.h>) and __has_include(<sys/wait.h>)
+  int fd_{-1};
+#else
+  std::ofstream out_{};
+#endif
+  std::size_t pending_{};
+  std::chrono::steady_clock::time_point synced_{std::chrono::steady_clock::now()};
 };
+#endif
 
-template <class T>
-struct not_ : op {
-  explicit constexpr not_(const T& t = {})
-      : t_{t}, value_{not static_cast<bool>(t)} {}
+#if __has_include(<ucontext.h>) and __has_include(<sys/mman.h>)
+/// Stack, below a guard region, to run a function on (on the same thread)
+/// which is painted beforehand so that its deepest use can be measured
+/// afterwards. A fault in the guard region (an overflow) is caught on an
+/// alternate signal stack and abandons the function. A frame larger than the
+/// guard region (64KiB) may skip over it, into whatever is mapped below.
+class painted_stack {
+  static constexpr unsigned char paint = 0xa5;
+  static constexpr std::size_t signal_stack_size = 64 * 1024;
+  static constexpr std::size_t guard_size = 64 * 1024;
 
-  [[nodiscard]] constexpr operator bool() const { return value_; }
-  [[nodiscard]] constexpr auto value() const { return get(t_); }
+ public:
+  explicit painted_stack(const std::size_t size)
+      : page_{static_cast<std::size_t>(sysconf(_SC_PAGESIZE))},
+        guarded_{(guard_size + page_ - 1) / page_ * page_},
+        size_{(size + page_ - 1) / page_ * page_},
+        signal_stack_{std::make_unique<char[]>(signal_stack_size)} {
+    if (auto* memory = mmap(nullptr, guarded_ + size_, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        memory != MAP_FAILED) {
+      mprotect(memory, guarded_, PROT_NONE);
+      memory_ = static_cast<unsigned char*>(memory);
+    }
+  }
+  painted_stack(const painted_stack&) = delete;
+  painted_stack& operator=(const painted_stack&) = delete;
+  ~painted_stack() {
+    if (memory_) {
+      munmap(memory_, guarded_ + size_);
+    }
+  }
 
-  const T t_{};
-  const bool value_{};
-};
+  [[nodiscard]] explicit operator bool() const { return memory_; }
+  [[nodiscard]] auto size() const -> std::size_t { return size_; }
+
+  /// calls `f` on the stack and returns how many bytes of it were used, or
+  /// nullopt when it overflowed (its objects are then not destroyed)
+  template <class F>
+  auto run(F& f) -> std::optional<std::size_t> {
+    std::fill(bottom(), bottom() + size_, paint);
+    call_ = [](void* fn) { (*static_cast<F*>(fn))(); };
+    fn_ = &f;
+    ucontext_t caller{};
+    ucontext_t callee{};
+    getcontext(&callee);  // no locals but the contexts live across it
+    callee.uc_stack.ss_sp = bottom();
+    callee.uc_stack.ss_size = size_;
+    callee.uc_link = &caller;
+    makecontext(&callee, &entry, 0);
+    if (not swap(caller, callee)) {
+      return std::nullopt;
+    }
+    const auto* const deepest =
+        std::find_if(bottom(), bottom() + size_,
+                     [](const auto byte) { return byte != paint; });
+    return static_cast<std::size_t>(bottom() + size_ - deepest);
+  }
 
-template <class>
-struct fatal_;
+ private:
+  static auto entry() -> void { call_(fn_); }
+  [[nodiscard]] auto bottom() const -> unsigned char* {
+    return memory_ + guarded_;
+  }
+
+  /// switches to `callee` with SIGSEGV handled on the signal stack, false
+  /// when it faulted in the guard region
+  auto swap(ucontext_t& caller, ucontext_t& callee) -> bool {
+    auto stack = stack_t{};
+    stack.ss_sp = signal_stack_.get();
+    stack.ss_size = signal_stack_size;
+    auto old_stack = stack_t{};
+    sigaltstack(&stack, &old_stack);
+    struct sigaction action{};
+    action.sa_sigaction = &on_fault;
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGSEGV, &action, &previous_);
+    sigjmp_buf overflow;
+    guard_ = memory_;
+    guard_size_ = guarded_;
+    jump_ = &overflow;
+    if (not sigsetjmp(overflow, 1)) {
+      swapcontext(&caller, &callee);
+    }
+    const auto completed = jump_ != nullptr;  // cleared by on_fault
+    jump_ = {};
+    sigaction(SIGSEGV, &previous_, nullptr);
+    sigaltstack(&old_stack, nullptr);
+    return completed;
+  }
 
-#if defined(__cpp_exceptions)
-template <class TExpr, class TException = void>
-struct throws_ : op {
-  constexpr explicit throws_(const TExpr& expr)
-      : value_{[&expr] {
-          try {
-            expr();
-            return false;
-          } catch (const TException&) {
-            return true;
-          } catch (...) {
-            return false;
-          }
-        }()} {}
-
-  [[nodiscard]] constexpr operator bool() const { return value_; }
-
-  const bool value_{};
+  static auto on_fault(int, siginfo_t* info, void*) -> void {
+    const auto* const address = static_cast<unsigned char*>(info->si_addr);
+    if (jump_ and address >= guard_ and address < guard_ + guard_size_) {
+      siglongjmp(*std::exchange(jump_, nullptr), 1);
+    }
+    sigaction(SIGSEGV, &previous_, nullptr);  // faults again, not ours
+  }
+
+  static inline thread_local void (*call_)(void*){};
+  static inline thread_local void* fn_{};
+  static inline thread_local sigjmp_buf* jump_{};
+  static inline thread_local const unsigned char* guard_{};
+  static inline thread_local std::size_t guard_size_{};
+  static inline struct sigaction previous_{};
+  std::size_t page_{};
+  std::size_t guarded_{};  // bytes of the guard region
+  std::size_t size_{};
+  unsigned char* memory_{};
+  std::unique_ptr<char[]> signal_stack_{};
 };
+#endif
 
-template <class TExpr>
-struct throws_<TExpr, void> : op {
-  constexpr explicit throws_(const TExpr& expr)
-      : value_{[&expr] {
-          try {
-            expr();
-            return false;
-          } catch (...) {
-            return true;
-          }
-        }()} {}
-
-  [[nodiscard]] constexpr operator bool() const { return value_; }
+#if defined(BOOST_UT_RUN_TOOLS)
+/// Threads, file descriptors and child processes of this process, read from
+/// /proc (empty elsewhere), compared around top-level tests (--leak-check)
+class resources {
+ public:
+  [[nodiscard]] static auto snapshot() -> resources {
+    auto r = resources{};
+    for (const auto& tid : files::list("/proc/self/task")) {
+      const auto task = "/proc/self/task/" + tid;
+      auto name = std::string{};
+      std::getline(std::ifstream{task + "/comm"}, name);
+      r.entries_.push_back({"thread " + tid, name});
+      auto children = std::ifstream{task + "/children"};
+      for (auto pid = std::string{}; children >> pid;) {
+        auto comm = std::string{};
+        std::getline(std::ifstream{"/proc/" + pid + "/comm"}, comm);
+        r.entries_.push_back({"child process " + pid, comm});
+      }
+    }
+    for (const auto& fd : files::list("/proc/self/fd")) {
+      auto target = files::read_link("/proc/self/fd/" + fd);
+      if (target.empty()) {
+        continue;  // the directory which was read, closed since
+      }
+      r.entries_.push_back({"fd " + fd, std::move(target)});
+    }
+    std::sort(r.entries_.begin(), r.entries_.end());
+    return r;
+  }
+
+  /// what is here but not in `before`, e.g. "thread 42 (worker)"
+  [[nodiscard]] auto leaked_since(const resources& before) const
+      -> std::vector<std::string> {
+    auto leaked = std::vector<std::string>{};
+    for (const auto& [what, detail] : entries_) {
+      if (not std::binary_search(before.entries_.cbegin(),
+                                 before.entries_.cend(),
+                                 std::pair{what, detail})) {
+        leaked.push_back(what + " (" + detail + ")");
+      }
+    }
+    return leaked;
+  }
 
-  const bool value_{};
+ private:
+  std::vector<std::pair<std::string, std::string>> entries_{};
 };
 
-template <class TExpr>
-struct nothrow_ : op {
-  constexpr explicit nothrow_(const TExpr& expr)
-      : value_{[&expr] {
-          try {
-            expr();
-            return true;
-          } catch (...) {
-            return false;
-          }
-        }()} {}
+/// SIGPROF driven sampler (--profile) attributing the stacks it captures, on
+/// any thread, to the running top-level test. The stacks are written as
+/// folded stacks ("suite;test;outer;...;inner count") for flame graphs, and
+/// the functions sampled the most are printed after each suite.
+class profiler {
+ public:
+  static constexpr auto interval = std::chrono::microseconds{1000};
+  static constexpr std::size_t max_depth = 64;
+  static constexpr std::size_t capacity = 1u << 14;  // samples per test
+  static constexpr std::size_t top = 10;
 
-  [[nodiscard]] constexpr operator bool() const { return value_; }
+  [[nodiscard]] explicit operator bool() const { return out_.is_open(); }
 
-  const bool value_{};
-};
+  auto start(const std::string& file) -> void {
+#if __has_include(<execinfo.h>) and __has_include(<sys/time.h>)
+    out_.open(file, std::ios::trunc);
+    if (not out_) {
+      return;
+    }
+    samples_ = std::make_unique<sample[]>(capacity);
+    auto* frame = static_cast<void*>(nullptr);
+    ::backtrace(&frame, 1);  // loads the unwinder, which allocates, up front
+    struct sigaction action{};
+    action.sa_handler = &on_signal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGPROF, &action, &previous_);
+    sampled_ = true;
+#if defined(__GLIBC__) and (__GLIBC__ > 2 or __GLIBC_MINOR__ >= 34) and \
+    defined(SIGEV_THREAD_ID)
+    // on the CPU time of the thread running the tests (timer_create is in
+    // libc since glibc 2.34, no -lrt)
+    auto event = sigevent{};
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = SIGPROF;
+    event._sigev_un._tid = gettid();
+    if (not timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &timer_)) {
+      const auto nsec = std::chrono::nanoseconds{interval}.count();
+      const auto spec = itimerspec{{0, nsec}, {0, nsec}};
+      timer_settime(timer_, 0, &spec, nullptr);
+      timed_ = true;
+      return;
+    }
 #endif
-
-#if __has_include(<unistd.h>) and __has_include(<sys/wait.h>)
-template <class TExpr>
-struct aborts_ : op {
-  constexpr explicit aborts_(const TExpr& expr)
-      : value_{[&expr]() -> bool {
-          if (const auto pid = fork(); not pid) {
-            expr();
-            std::exit(0);
-          }
-          auto exit_status = 0;
-          wait(&exit_status);
-          return exit_status;
-        }()} {}
-
-  [[nodiscard]] constexpr operator bool() const { return value_; }
-
-  const bool value_{};
-};
+    // on the CPU time of the process, samples of other threads are dropped
+    const auto usec = static_cast<suseconds_t>(interval.count());
+    const auto timer = itimerval{{0, usec}, {0, usec}};
+    setitimer(ITIMER_PROF, &timer, nullptr);
+#else
+    static_cast<void>(file);
 #endif
-}  // namespace detail
-
-namespace type_traits {
-template <class T>
-concept is_op = std::derived_from<T, detail::op>;
+  }
 
-template <typename T, typename = void>
-struct is_stream_insertable : std::false_type {};
+  auto stop() -> void {
+#if __has_include(<execinfo.h>) and __has_include(<sys/time.h>)
+    if (*this) {
+#if defined(__GLIBC__) and (__GLIBC__ > 2 or __GLIBC_MINOR__ >= 34) and \
+    defined(SIGEV_THREAD_ID)
+      if (std::exchange(timed_, false)) {
+        timer_delete(timer_);
+      }
+#endif
+      const auto timer = itimerval{};
+      setitimer(ITIMER_PROF, &timer, nullptr);
+      sigaction(SIGPROF, &previous_, nullptr);
+      out_.close();
+    }
+#endif
+  }
 
-template <typename T>
-struct is_stream_insertable<
-    T, std::void_t<decltype(std::declval<std::ostream&>()
-                            << detail::get(std::declval<T>()))>>
-    : std::true_type {};
-template <typename T>
-inline constexpr bool is_stream_insertable_v = is_stream_insertable<T>::value;
-}  // namespace type_traits
+  /// attributes the following samples to a top-level test
+  auto begin() -> void {
+    if (*this) {
+      next_ = 0;
+      test_ = ++tests_;
+    }
+  }
 
-struct colors {
-  std::string_view none = "\033[0m";
-  std::string_view pass = "\033[32m";
-  std::string_view fail = "\033[31m";
-  std::string_view skip = "\033[33m";
-};
+  /// collects the samples taken since begin
+  auto end(std::string_view test) -> void {
+    if (not *this) {
+      return;
+    }
+    const auto id = test_.exchange(0);
+    auto& stacks = suite_.emplace_back(std::string{test}, stacks_t{}).second;
+    for (auto i = 0u; i < std::min(next_.load(), capacity); ++i) {
+      // samples still being taken on another thread are dropped
+      if (const auto& s = samples_[i]; s.test.load(std::memory_order_acquire) == id) {
+        // skips the signal handler and trampoline
+        ++stacks[{s.frames.cbegin() + std::min(s.depth, 2), s.frames.cbegin() + s.depth}];
+      }
+    }
+    dropped_ += next_ > capacity ? next_ - capacity : 0;
+  }
 
-class printer {
-  [[nodiscard]] auto color(const bool cond) {
-    return cond ? colors_.pass : colors_.fail;
+  /// writes the samples of the tests of a suite and prints its hottest
+  /// functions to `os`
+  auto flush(std::string_view suite, std::ostream& os) -> void {
+    if (not *this) {
+      return;
+    }
+    auto names = symbols();
+    auto self = std::unordered_map<std::string_view, std::size_t>{};
+    auto total = std::size_t{};
+    for (const auto& [test, stacks] : suite_) {
+      for (const auto& [frames, count] : stacks) {
+        out_ << suite << ';' << test;
+        for (auto frame = frames.crbegin(); frame != frames.crend(); ++frame) {
+          out_ << ';' << names[*frame];
+        }
+        out_ << ' ' << count << '\n';
+        self[frames.empty() ? std::string_view{"?"}
+                            : std::string_view{names[frames.front()]}] += count;
+        total += count;
+      }
+    }
+    out_.flush();
+    suite_.clear();
+    if (not total) {
+      return;
+    }
+    auto hottest = std::vector<std::pair<std::string_view, std::size_t>>(
+        self.cbegin(), self.cend());
+    std::sort(hottest.begin(), hottest.end(), [](const auto& lhs, const auto& rhs) {
+      return std::tie(rhs.second, lhs.first) < std::tie(lhs.second, rhs.first);
+    });
+    hottest.resize(std::min(hottest.size(), top));
+    os << "profile of suite '" << suite << "': " << total << " samples every "
+       << interval.count() << "us";
+    if (dropped_) {
+      os << " (" << std::exchange(dropped_, 0) << " dropped)";
+    }
+    os << "\n  self    samples  function\n";
+    const auto pad = [](std::string s, const std::size_t width) {
+      return s.insert(0, s.size() < width ? width - s.size() : 0, ' ');
+    };
+    for (const auto& [function, count] : hottest) {
+      auto percent = std::ostringstream{};
+      percent.precision(1);
+      percent << std::fixed << 100.0 * static_cast<double>(count) / static_cast<double>(total) << '%';
+      os << "  " << pad(percent.str(), 6) << "  " << pad(std::to_string(count), 7) << "  " << function << '\n';
+    }
+    os << std::flush;
   }
 
- public:
-  printer() = default;
-  /*explicit(false)*/ printer(const colors colors) : colors_{colors} {}
+ private:
+  using stacks_t = std::map<std::vector<void*>, std::size_t>;
 
-  template <class T>
-  auto& operator<<(const T& t) {
-    out_ << detail::get(t);
-    return *this;
-  }
+  struct sample {
+    std::atomic<std::size_t> test{};
+    int depth{};
+    std::array<void*, max_depth> frames{};
+  };
 
-  template <class T>
-    requires std::ranges::range<T> && (!concepts::ostreamable<T>)
-  auto& operator<<(T&& t) {
-    *this << '{';
-    auto first = true;
-    for (const auto& arg : t) {
-      *this << (first ? "" : ", ") << arg;
-      first = false;
+  /// names of the functions of the frames of the collected samples
+  [[nodiscard]] auto symbols() -> std::unordered_map<void*, std::string> {
+    auto names = std::unordered_map<void*, std::string>{};
+#if __has_include(<execinfo.h>) and __has_include(<sys/time.h>)
+    auto frames = std::vector<void*>{};
+    for (const auto& [test, stacks] : suite_) {
+      for (const auto& [stack, count] : stacks) {
+        for (auto* frame : stack) {
+          if (names.try_emplace(frame).second) {
+            frames.push_back(frame);
+          }
+        }
+      }
     }
-    *this << '}';
-    return *this;
+    auto unexported = std::map<std::string, std::vector<void*>>{};  // by binary
+    auto* symbols = ::backtrace_symbols(frames.data(), static_cast<int>(frames.size()));
+    for (auto i = 0u; symbols and i < frames.size(); ++i) {
+      const auto symbol = std::string_view{symbols[i]};
+      names[frames[i]] = function(symbol);
+      if (const auto open = symbol.find("(+"); open != std::string_view::npos) {
+        unexported[std::string{symbol.substr(0, open)}].push_back(frames[i]);
+      }
+    }
+    std::free(symbols);
+    for (const auto& [binary, offsets] : unexported) {
+      addr2line(binary, offsets, names);
+    }
+#endif
+    return names;
+  }
+
+#if __has_include(<execinfo.h>) and __has_include(<sys/time.h>)
+  /// names the functions of a binary which backtrace_symbols could not (not
+  /// linked with -rdynamic, or static) from its symbol table by addr2line,
+  /// where installed; their names stay "binary+0x1d" otherwise
+  static auto addr2line(const std::string& binary,
+                        const std::vector<void*>& frames,
+                        std::unordered_map<void*, std::string>& names) -> void {
+    if (const auto file = files::stat(binary); not file or not file->regular) {
+      return;  // e.g. linux-vdso.so.1
+    }
+    auto command = std::string{"addr2line -f -C -e '"};
+    for (const auto c : binary) {
+      command += c == '\'' ? std::string{"'\\''"} : std::string{c};
+    }
+    command += '\'';
+    for (auto* frame : frames) {
+      const auto& name = names[frame];  // binary+0x1d
+      command += ' ' + name.substr(name.rfind('+') + 1);
+    }
+    command += " 2>/dev/null";
+    auto* pipe = ::popen(command.c_str(), "r");
+    if (not pipe) {
+      return;
+    }
+    const auto line = [pipe] {
+      auto text = std::string{};
+      for (auto c = std::fgetc(pipe); c != EOF and c != '\n'; c = std::fgetc(pipe)) {
+        text += static_cast<char>(c);
+      }
+      return text;
+    };
+    for (auto* frame : frames) {
+      const auto function = line();
+      if (line().empty()) {  // file:line
+        break;
+      }
+      if (function != "??") {
+        names[frame] = function;
+      }
+    }
+    ::pclose(pipe);
   }
+#endif
 
-  auto& operator<<(std::string_view sv) {
-    out_ << sv;
-    return *this;
+  /// "binary(symbol+0x1d) [0x..]" demangled to "symbol", or "binary+0x1d"
+  /// for functions without exported symbols
+  [[nodiscard]] static auto function(std::string_view symbol) -> std::string {
+    const auto open = symbol.find('(');
+    const auto plus = symbol.find('+', open);
+    const auto close = symbol.find(')', open);
+    if (open == std::string_view::npos or close == std::string_view::npos) {
+      return std::string{symbol};
+    }
+    auto name = std::string{symbol.substr(open + 1, std::min(plus, close) - open - 1)};
+    if (name.empty()) {
+      const auto binary = symbol.substr(0, open);
+      return std::string{binary.substr(binary.find_last_of('/') + 1)} +
+             std::string{symbol.substr(plus, close - plus)};
+    }
+#if __has_include(<cxxabi.h>)
+    auto status = 0;
+    if (auto* demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+        demangled) {
+      name = demangled;
+      std::free(demangled);
+    }
+#endif
+    return name;
   }
 
-  template <class TLhs, class TRhs>
-  auto& operator<<(const detail::eq_<TLhs, TRhs>& op) {
-    return (*this << color(op) << op.lhs() << " == " << op.rhs()
-                  << colors_.none);
+#if __has_include(<execinfo.h>) and __has_include(<sys/time.h>)
+  static auto on_signal(int) -> void {
+    const auto id = test_.load();
+    if (not id or not sampled_) {  // another thread than the test's
+      return;
+    }
+    const auto error = errno;
+    if (const auto i = next_++; i < capacity) {
+      auto& s = samples_[i];
+      s.test.store(0, std::memory_order_relaxed);
+      s.depth = ::backtrace(s.frames.data(), static_cast<int>(s.frames.size()));
+      s.test.store(id, std::memory_order_release);
+    }
+    errno = error;
   }
 
-  template <class TLhs, class TRhs, class TEpsilon>
-  auto& operator<<(const detail::approx_<TLhs, TRhs, TEpsilon>& op) {
-    return (*this << color(op) << op.lhs() << " ~ (" << op.rhs() << " +/- "
-                  << op.epsilon() << ')' << colors_.none);
-  }
+  struct sigaction previous_{};
+#if defined(__GLIBC__) and (__GLIBC__ > 2 or __GLIBC_MINOR__ >= 34) and \
+    defined(SIGEV_THREAD_ID)
+  timer_t timer_{};
+  bool timed_{};
+#endif
+#endif
+  static inline thread_local bool sampled_{};  // runs the tests
+  static inline std::atomic<std::size_t> test_{};  // 0: not sampling
+  static inline std::atomic<std::size_t> next_{};
+  static inline std::unique_ptr<sample[]> samples_{};
+  std::size_t tests_{};
+  std::size_t dropped_{};
+  std::vector<std::pair<std::string, stacks_t>> suite_{};
+  std::ofstream out_{};
+};
+#endif
 
-  template <class TLhs, class TRhs>
-  auto& operator<<(const detail::neq_<TLhs, TRhs>& op) {
-    return (*this << color(op) << op.lhs() << " != " << op.rhs()
-                  << colors_.none);
+/// Tracepoints at suite and test boundaries and assertion failures, to slice
+/// perf, bpftrace and ftrace sessions over a test executable per test:
+/// USDT probes of the `boost_ut` provider (from <sys/sdt.h>, if BOOST_UT_USDT
+/// is defined), which are nops until a tracer attaches,
+/// and lines written to the ftrace marker, or a file (--trace-markers).
+/// Names are passed as a pointer and a size, e.g. `str(arg1, arg2)`.
+class trace {
+ public:
+  /// opens the file to write markers to ("ftrace": the ftrace marker),
+  /// whether it could be opened
+  static auto markers(const std::string& file) -> bool {
+#if __has_include(<unistd.h>) and __has_include(<sys/wait.h>)
+    close();
+    if (file != "ftrace") {
+      marker_ = ::open(file.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+      return marker_ >= 0;
+    }
+    for (const auto* path : {"/sys/kernel/tracing/trace_marker",
+                             "/sys/kernel/debug/tracing/trace_marker"}) {
+      if ((marker_ = ::open(path, O_WRONLY | O_CLOEXEC)) >= 0) {
+        return true;
+      }
+    }
+    return false;
+#else
+    static_cast<void>(file);
+    return false;
+#endif
   }
 
-  template <class TLhs, class TRhs>
-  auto& operator<<(const detail::gt_<TLhs, TRhs>& op) {
-    return (*this << color(op) << op.lhs() << " > " << op.rhs()
-                  << colors_.none);
+  static auto close() -> void {
+#if __has_include(<unistd.h>) and __has_include(<sys/wait.h>)
+    if (marker_ >= 0) {
+      ::close(std::exchange(marker_, -1));
+    }
+#endif
   }
 
-  template <class TLhs, class TRhs>
-  auto& operator<<(const detail::ge_<TLhs, TRhs>& op) {
-    return (*this << color(op) << op.lhs() << " >= " << op.rhs()
-                  << colors_.none);
+  /// the run of the test running on this thread, or else of the test this
+  /// (worker) thread was adopted by, 0 outside of tests
+  [[nodiscard]] static auto running() -> std::size_t {
+    return running_.empty() ? adopted_ : running_.back();
   }
 
-  template <class TLhs, class TRhs>
-  auto& operator<<(const detail::lt_<TRhs, TLhs>& op) {
-    return (*this << color(op) << op.lhs() << " < " << op.rhs()
-                  << colors_.none);
-  }
+  /// attributes what happens on this worker thread to the run `id`
+  static auto adopt(const std::size_t id) -> void { adopted_ = id; }
 
-  template <class TLhs, class TRhs>
-  auto& operator<<(const detail::le_<TRhs, TLhs>& op) {
-    return (*this << color(op) << op.lhs() << " <= " << op.rhs()
-                  << colors_.none);
+  static auto suite_begin(std::string_view name) -> void {
+#if defined(BOOST_UT_HAS_USDT)
+    DTRACE_PROBE2(boost_ut, suite_begin, name.data(), name.size());
+#endif
+    mark("suite_begin", name);
   }
 
-  template <class TLhs, class TRhs>
-  auto& operator<<(const detail::and_<TLhs, TRhs>& op) {
-    return (*this << '(' << op.lhs() << color(op) << " and " << colors_.none
-                  << op.rhs() << ')');
+  static auto suite_end(std::string_view name) -> void {
+#if defined(BOOST_UT_HAS_USDT)
+    DTRACE_PROBE2(boost_ut, suite_end, name.data(), name.size());
+#endif
+    mark("suite_end", name);
   }
 
-  template <class TLhs, class TRhs>
-  auto& operator<<(const detail::or_<TLhs, TRhs>& op) {
-    return (*this << '(' << op.lhs() << color(op) << " or " << colors_.none
-                  << op.rhs() << ')');
+  /// numbers the run of the test, nested in the running one (if any)
+  static auto test_begin(std::string_view name) -> void {
+    const auto id = running_.emplace_back(++runs_);
+#if defined(BOOST_UT_HAS_USDT)
+    DTRACE_PROBE3(boost_ut, test_begin, id, name.data(), name.size());
+#endif
+    mark("test_begin", name, id);
   }
 
-  template <class T>
-  auto& operator<<(const detail::not_<T>& op) {
-    return (*this << color(op) << "not " << op.value() << colors_.none);
-  }
+  /// how many runs of this thread are nested, see unwind
+  [[nodiscard]] static auto depth() -> std::size_t { return running_.size(); }
 
-  template <class T>
-  auto& operator<<(const detail::fatal_<T>& fatal) {
-    return (*this << fatal.get());
+  /// ends the runs nested deeper than `depth` as failed, abandoned by a jump
+  static auto unwind(const std::size_t depth) -> void {
+    while (running_.size() > depth) {
+      test_end("(abandoned)", false);
+    }
   }
 
-#if defined(__cpp_exceptions)
-  template <class TExpr, class TException>
-  auto& operator<<(const detail::throws_<TExpr, TException>& op) {
-    return (*this << color(op) << "throws<"
-                  << reflection::type_name<TException>() << ">"
-                  << colors_.none);
+  static auto test_end(std::string_view name, const bool passed) -> void {
+    const auto id = running_.back();
+    running_.pop_back();
+#if defined(BOOST_UT_HAS_USDT)
+    DTRACE_PROBE4(boost_ut, test_end, id, name.data(), name.size(), passed);
+#endif
+    mark(passed ? "test_end pass" : "test_end fail", name, id);
   }
 
-  template <class TExpr>
-  auto& operator<<(const detail::throws_<TExpr, void>& op) {
-    return (*this << color(op) << "throws" << colors_.none);
+  static auto assertion_fail(const char* file, const std::size_t line) -> void {
+    const auto id = running();
+#if defined(BOOST_UT_HAS_USDT)
+    DTRACE_PROBE3(boost_ut, assertion_fail, id, file, line);
+#endif
+    mark("assertion_fail", std::string{file} + ':' + std::to_string(line), id);
   }
 
-  template <class TExpr>
-  auto& operator<<(const detail::nothrow_<TExpr>& op) {
-    return (*this << color(op) << "nothrow" << colors_.none);
-  }
-#endif
-
+ private:
+  /// writes e.g. "boost_ut test_begin 3 name" in a single write
+  static auto mark(std::string_view event, std::string_view what,
+                   const std::size_t id = 0) -> void {
 #if __has_include(<unistd.h>) and __has_include(<sys/wait.h>)
-  template <class TExpr>
-  auto& operator<<(const detail::aborts_<TExpr>& op) {
-    return (*this << color(op) << "aborts" << colors_.none);
-  }
+    if (marker_ < 0) {
+      return;
+    }
+    auto line = std::string{"boost_ut "};
+    line.append(event);
+    if (id) {
+      line.append(' ' + std::to_string(id));
+    }
+    line.append(1, ' ').append(what).append(1, '\n');
+    static_cast<void>(::write(marker_, line.data(), line.size()));
+#else
+    static_cast<void>(event);
+    static_cast<void>(what);
+    static_cast<void>(id);
 #endif
-
-  template <class T>
-  auto& operator<<(const detail::type_<T>&) {
-    return (*this << reflection::type_name<T>());
   }
 
-  auto str() const { return out_.str(); }
-  const auto& colors() const { return colors_; }
-
- private:
-  ut::colors colors_{};
-  std::ostringstream out_{};
+  static inline int marker_{-1};
+  static inline std::atomic<std::size_t> runs_{};
+  static inline thread_local std::vector<std::size_t> running_{};
+  static inline thread_local std::size_t adopted_{};
 };
 
-template <class TPrinter = printer>
-class reporter {
- public:
-  constexpr auto operator=(TPrinter printer) {
-    printer_ = static_cast<TPrinter&&>(printer);
+#if defined(BOOST_UT_RUN_TOOLS)
+/// Minimal subset of `tests` (ordinals of the tests declared before a victim)
+/// which still makes the victim fail when run before it, given that all of
+/// them do. `fails(ordinals)` runs the ordinals followed by the victim.
+/// Halves are tried on their own first, if neither fails alone the culprits
+/// are split across both and each half is minimized against the other.
+template <class TFails>
+[[nodiscard]] auto bisect_pollution(std::vector<std::size_t> tests,
+                                    TFails& fails,
+                                    const std::vector<std::size_t>& fixed = {})
+    -> std::vector<std::size_t> {
+  const auto merge = [](auto lhs, const auto& rhs) {
+    lhs.insert(lhs.end(), rhs.cbegin(), rhs.cend());
+    std::sort(lhs.begin(), lhs.end());
+    return lhs;
+  };
+
+  while (tests.size() > 1) {
+    const auto half = tests.cbegin() + static_cast<std::ptrdiff_t>(tests.size() / 2);
+    auto lhs = std::vector<std::size_t>(tests.cbegin(), half);
+    auto rhs = std::vector<std::size_t>(half, tests.cend());
+    if (fails(merge(fixed, lhs))) {
+      tests = std::move(lhs);
+    } else if (fails(merge(fixed, rhs))) {
+      tests = std::move(rhs);
+    } else {
+      const auto culprits = bisect_pollution(lhs, fails, merge(fixed, rhs));
+      return merge(culprits,
+                   bisect_pollution(rhs, fails, merge(fixed, culprits)));
+    }
   }
+  return tests;
+}
+#endif
 
-  auto on(events::run_begin) -> void {}
+class metrics {
+ public:
+  enum class kind : std::uint8_t { metric, counter, gauge };
 
-  auto on(events::test_begin test_begin) -> void {
-    printer_ << "Running \"" << test_begin.name << "\"...";
-    fails_ = asserts_.fail;
-  }
+  class entry {
+   public:
+    entry(std::string_view name, const metrics::kind k) : name_{name}, kind_{k} {}
 
-  auto on(events::test_run test_run) -> void {
-    printer_ << "\n \"" << test_run.name << "\"...";
-  }
+    auto add(const double value) -> void {
+      auto current = value_.load(std::memory_order_relaxed);
+      while (not value_.compare_exchange_weak(current, current + value,
+                                              std::memory_order_relaxed)) {
+      }
+      touched_.store(true, std::memory_order_relaxed);
+    }
 
-  auto on(events::test_skip test_skip) -> void {
-    printer_ << test_skip.name << "...SKIPPED\n";
-    ++tests_.skip;
-  }
+    auto set(const double value) -> void {
+      value_.store(value, std::memory_order_relaxed);
+      seq_.store(sequence_.fetch_add(1, std::memory_order_relaxed) + 1,
+                 std::memory_order_relaxed);
+      touched_.store(true, std::memory_order_relaxed);
+    }
 
-  auto on(events::test_end) -> void {
-    if (asserts_.fail > fails_) {
-      ++tests_.fail;
-      printer_ << '\n'
-               << printer_.colors().fail << "FAILED" << printer_.colors().none
-               << '\n';
-    } else {
-      ++tests_.pass;
-      printer_ << printer_.colors().pass << "PASSED" << printer_.colors().none
-               << '\n';
+    [[nodiscard]] auto name() const -> std::string_view { return name_; }
+
+   private:
+    friend class metrics;
+
+    std::string name_{};
+    metrics::kind kind_{};
+    std::atomic<double> value_{};
+    std::atomic<std::uint64_t> seq_{};
+    std::atomic<bool> touched_{};
+  };
+
+  [[nodiscard]] static auto get(std::string_view name, const kind k)
+      -> entry& {
+    auto& local = store::local();
+    auto& index = local.index[static_cast<std::size_t>(k)];
+    if (const auto found = index.find(name); found != index.cend()) {
+      return *found->second;
+    }
+    const std::scoped_lock lock{mutex_};
+    auto& e = local.entries.emplace_back(name, k);
+    index.emplace(e.name_, &e);
+    return e;
+  }
+
+  /// current value across all threads, without resetting it
+  [[nodiscard]] static auto value(std::string_view name, const kind k)
+      -> double {
+    const std::scoped_lock lock{mutex_};
+    double result{};
+    std::uint64_t seq{};
+    for (auto* s = head_; s; s = s->next) {
+      for (auto& e : s->entries) {
+        if (e.kind_ != k or e.name_ != name) {
+          continue;
+        }
+        if (k != kind::gauge) {
+          result += e.value_.load(std::memory_order_relaxed);
+        } else if (const auto e_seq = e.seq_.load(std::memory_order_relaxed);
+                   e_seq > seq) {
+          seq = e_seq;
+          result = e.value_.load(std::memory_order_relaxed);
+        }
+      }
     }
+    return result;
   }
 
-  template <class TMsg>
-  auto on(events::log<TMsg> l) -> void {
-    printer_ << l.msg;
+  /// collects and resets everything recorded since the previous drain
+  template <class TOn>
+  static auto drain(TOn on) -> void {
+    struct result {
+      std::string_view name{};
+      metrics::kind kind{};
+      double value{};
+      std::uint64_t seq{};
+    };
+    std::vector<result> results{};
+    {
+      const std::scoped_lock lock{mutex_};
+      for (auto* s = head_; s; s = s->next) {
+        for (auto& e : s->entries) {
+          if (not e.touched_.exchange(false, std::memory_order_relaxed)) {
+            continue;
+          }
+          auto it = std::find_if(results.begin(), results.end(),
+                                 [&e](const auto& r) {
+                                   return r.kind == e.kind_ and
+                                          r.name == e.name_;
+                                 });
+          if (it == results.end()) {
+            it = results.insert(results.end(), {e.name_, e.kind_});
+          }
+          if (e.kind_ != kind::gauge) {
+            it->value += e.value_.exchange(0, std::memory_order_relaxed);
+          } else if (const auto seq = e.seq_.load(std::memory_order_relaxed);
+                     seq > it->seq) {
+            it->seq = seq;
+            it->value = e.value_.load(std::memory_order_relaxed);
+          }
+        }
+      }
+    }
+    for (const auto& r : results) {
+      on(events::metric{.name = r.name, .kind = name(r.kind), .value = r.value});
+    }
   }
 
-  auto on(events::exception exception) -> void {
-    printer_ << "\n  " << printer_.colors().fail
-             << "Unexpected exception with message:\n"
-             << exception.what() << printer_.colors().none;
-    ++asserts_.fail;
+  [[nodiscard]] static auto format(const double value) -> std::string {
+    if (const auto integral = static_cast<std::int64_t>(value);
+        static_cast<double>(integral) == value) {
+      return std::to_string(integral);
+    }
+    std::ostringstream oss{};
+    oss << value;
+    return oss.str();
+  }
+
+  [[nodiscard]] static constexpr auto name(const kind k) -> std::string_view {
+    switch (k) {
+      case kind::counter:
+        return "counter";
+      case kind::gauge:
+        return "gauge";
+      default:
+        return "metric";
+    }
   }
 
-  template <class TExpr>
-  auto on(events::assertion_pass<TExpr>) -> void {
-    ++asserts_.pass;
+ private:
+  /// per-thread entries; stores are never freed, only handed over to the next
+  /// thread once their owner exits, so entry references stay valid
+  struct hash {
+    using is_transparent = void;
+    [[nodiscard]] auto operator()(const std::string_view name) const
+        -> std::size_t {
+      return std::hash<std::string_view>{}(name);
+    }
+  };
+
+  struct store {
+    std::deque<entry> entries{};
+    // entries by name, of each kind, only used by the owning thread
+    std::array<std::unordered_map<std::string, entry*, hash, std::equal_to<>>,
+               3>
+        index{};
+    store* next{};
+    bool owned{};
+
+    [[nodiscard]] static auto local() -> store& {
+      static thread_local store* local{};
+      if (not local) {
+        const std::scoped_lock lock{mutex_};
+        for (auto* s = head_; s and not local; s = s->next) {
+          if (not s->owned) {
+            local = s;
+          }
+        }
+        if (not local) {
+          local = new store{};
+          local->next = head_;
+          head_ = local;
+        }
+        local->owned = true;
+        static thread_local const release release_{local};
+      }
+      return *local;
+    }
+  };
+
+  struct release {
+    store* s{};
+    ~release() {
+      const std::scoped_lock lock{mutex_};
+      s->owned = false;
+    }
+  };
+
+  static inline std::mutex mutex_{};
+  static inline store* head_{};
+  static inline std::atomic<std::uint64_t> sequence_{};
+};
+
+struct counter_ : op {
+  explicit counter_(metrics::entry& entry) : entry_{&entry} {}
+
+  auto operator++() -> counter_& {
+    entry_->add(1);
+    return *this;
+  }
+  auto operator++(int) -> counter_ {
+    entry_->add(1);
+    return *this;
+  }
+  auto operator+=(const std::int64_t n) -> counter_& {
+    entry_->add(static_cast<double>(n));
+    return *this;
   }
 
-  template <class TExpr>
-  auto on(events::assertion_fail<TExpr> assertion) -> void {
-    constexpr auto short_name = [](std::string_view name) {
-      return name.rfind('/') != std::string_view::npos
-                 ? name.substr(name.rfind('/') + 1)
-                 : name;
-    };
-    printer_ << "\n  " << short_name(assertion.location.file_name()) << ':'
-             << assertion.location.line() << ':' << printer_.colors().fail
-             << "FAILED" << printer_.colors().none << " [" << std::boolalpha
-             << assertion.expr << printer_.colors().none << ']';
-    ++asserts_.fail;
+  [[nodiscard]] auto get() const -> std::int64_t {
+    return static_cast<std::int64_t>(
+        metrics::value(entry_->name(), metrics::kind::counter));
   }
 
-  auto on(const events::fatal_assertion&) -> void {}
+ private:
+  metrics::entry* entry_{};
+};
 
-  auto on(events::summary) -> void {
-    if (tests_.fail or asserts_.fail) {
-      printer_ << "\n========================================================"
-                  "=======================\n"
-               << "tests:   " << (tests_.pass + tests_.fail) << " | "
-               << printer_.colors().fail << tests_.fail << " failed"
-               << printer_.colors().none << '\n'
-               << "asserts: " << (asserts_.pass + asserts_.fail) << " | "
-               << asserts_.pass << " passed"
-               << " | " << printer_.colors().fail << asserts_.fail << " failed"
-               << printer_.colors().none << '\n';
-      std::cerr << printer_.str() << std::endl;
-    } else {
-      std::cout << printer_.colors().pass << "All tests passed"
-                << printer_.colors().none << " (" << asserts_.pass
-                << " asserts in " << tests_.pass << " tests)\n";
+#if defined(BOOST_UT_RUN_TOOLS)
+/// Samples of a test looped for a duration (--soak): the resident set, the
+/// heap in use (glibc), open fds and threads, between iterations, and the
+/// median duration of the iterations in between. Straight lines are fitted
+/// to them once the warm up is over, to tell growth from noise.
+class soak {
+ public:
+  using clock = std::chrono::steady_clock;
+  static constexpr std::size_t samples = 100;  // over the duration
+  static constexpr double warm_up = 0.2;       // of the samples, ignored
+  static constexpr double max_memory_growth = 0.1;  // of the memory in use
+  static constexpr double min_memory_growth = 1 << 20;
+  static constexpr double max_latency_drift = 0.5;
+
+  explicit soak(const clock::duration duration)
+      : start_{clock::now()},
+        end_{start_ + duration},
+        interval_{duration / samples} {
+    sample();
+  }
+
+  /// records an iteration which took `took`, sampling every interval
+  auto iteration(const clock::duration took) -> void {
+    ++iterations_;
+    latencies_.push_back(took);
+    if (clock::now() - last_ >= interval_) {
+      sample();
+    }
+  }
 
-      if (tests_.skip) {
-        std::cout << tests_.skip << " tests skipped\n";
+  [[nodiscard]] auto done() const -> bool { return clock::now() >= end_; }
+
+  /// reports the growth over the soak as gauges and describes the growth
+  /// beyond the thresholds, empty when there is none
+  [[nodiscard]] auto verdict() const -> std::string {
+    metrics::get("iterations", metrics::kind::gauge)
+        .set(static_cast<double>(iterations_));
+    const auto first = std::max<std::size_t>(
+        1, static_cast<std::size_t>(warm_up *
+                                    static_cast<double>(series_.size())));
+    if (series_.size() < first + 4) {
+      return {};
+    }
+    auto message = std::string{};
+    const auto check = [&](const char* name, auto value, const auto limit,
+                           const char* unit) {
+      auto [from, to] = fit(first, value);
+      metrics::get(std::string{name} + "_growth", metrics::kind::gauge)
+          .set(static_cast<double>(static_cast<std::int64_t>(to - from)));
+      if (to - from > limit(from)) {
+        message += std::string{message.empty() ? "" : ", "} + name +
+                   " grew from " + std::to_string(static_cast<std::int64_t>(from)) +
+                   " to " + std::to_string(static_cast<std::int64_t>(to)) + unit;
+      }
+    };
+    const auto memory = [](const double from) {
+      return std::max(min_memory_growth, max_memory_growth * from);
+    };
+    const auto any = [](double) { return 0.5; };
+    check("rss", [](const auto& s) { return s.rss; }, memory, " bytes");
+    check("heap", [](const auto& s) { return s.heap; }, memory, " bytes");
+    check("fds", [](const auto& s) { return s.fds; }, any, "");
+    check("threads", [](const auto& s) { return s.threads; }, any, "");
+    const auto [from, to] =
+        fit(first, [](const auto& s) { return s.latency; });
+    if (from > 0) {
+      metrics::get("latency_drift", metrics::kind::gauge).set(to / from - 1);
+      // the first and last thirds too, as a few stalls can tilt the line
+      const auto third = (series_.size() - first) / 3;
+      if (to / from - 1 > max_latency_drift and
+          median(series_.size() - third, series_.size()) >
+              (1 + max_latency_drift) * median(first, first + third)) {
+        message += std::string{message.empty() ? "" : ", "} +
+                   "an iteration slowed down from " +
+                   std::to_string(static_cast<std::int64_t>(from)) + " to " +
+                   std::to_string(static_cast<std::int64_t>(to)) + " us";
       }
+    }
+    return message.empty() ? message : "soak: " + message;
+  }
 
-      std::cout.flush();
+ private:
+  struct sample_t {
+    double time{};  // seconds since the start
+    double rss{};
+    double heap{};
+    double fds{};
+    double threads{};
+    double latency{};  // median of the iterations since the previous, us
+  };
+
+  auto sample() -> void {
+    last_ = clock::now();
+    auto s = sample_t{
+        .time = std::chrono::duration<double>(last_ - start_).count()};
+#if __has_include(<unistd.h>)
+    auto statm = std::ifstream{"/proc/self/statm"};
+    auto size = 0.0;
+    if (statm >> size >> s.rss) {
+      s.rss *= static_cast<double>(::sysconf(_SC_PAGESIZE));
+    }
+#endif
+#if defined(__GLIBC__) and (__GLIBC__ > 2 or __GLIBC_MINOR__ >= 33)
+    const auto info = ::mallinfo2();
+    s.heap = static_cast<double>(info.uordblks + info.hblkhd);
+#endif
+    const auto count = [](const char* path) {
+      return static_cast<double>(files::list(path).size());
+    };
+    s.fds = count("/proc/self/fd");
+    s.threads = count("/proc/self/task");
+    if (not latencies_.empty()) {
+      const auto middle = latencies_.begin() + latencies_.size() / 2;
+      std::nth_element(latencies_.begin(), middle, latencies_.end());
+      s.latency = std::chrono::duration<double, std::micro>(*middle).count();
+      latencies_.clear();
     }
+    series_.push_back(s);
   }
 
- protected:
-  struct {
-    std::size_t pass{};
-    std::size_t fail{};
-    std::size_t skip{};
-  } tests_{};
+  /// median latency of the samples in [first, last)
+  [[nodiscard]] auto median(const std::size_t first,
+                            const std::size_t last) const -> double {
+    auto latencies = std::vector<double>{};
+    for (auto i = first; i < last; ++i) {
+      latencies.push_back(series_[i].latency);
+    }
+    const auto middle = latencies.begin() + latencies.size() / 2;
+    std::nth_element(latencies.begin(), middle, latencies.end());
+    return *middle;
+  }
+
+  /// the least squares line through the samples from `first` on, at the
+  /// first and the last of them
+  template <class TValue>
+  [[nodiscard]] auto fit(const std::size_t first, const TValue& value) const
+      -> std::pair<double, double> {
+    auto n = 0.0, t = 0.0, v = 0.0, tt = 0.0, tv = 0.0;
+    for (auto i = first; i < series_.size(); ++i) {
+      const auto& s = series_[i];
+      n += 1;
+      t += s.time;
+      v += value(s);
+      tt += s.time * s.time;
+      tv += s.time * value(s);
+    }
+    const auto spread = n * tt - t * t;
+    const auto slope = spread > 0 ? (n * tv - t * v) / spread : 0;
+    const auto intercept = (v - slope * t) / n;
+    return {intercept + slope * series_[first].time,
+            intercept + slope * series_.back().time};
+  }
+
+  clock::time_point start_{};
+  clock::time_point end_{};
+  clock::duration interval_{};
+  clock::time_point last_{};
+  std::size_t iterations_{};
+  std::vector<clock::duration> latencies_{};
+  std::vector<sample_t> series_{};
+};
+#endif
 
-  struct {
-    std::size_t pass{};
-    std::size_t fail{};
-  } asserts_{};
+/// Counter-based (SplitMix64) UniformRandomBitGenerator, the n-th value only
+/// depends on the key and n. Keys are derived from the run seed and the full
+/// path of the running test, so values don't depend on the execution order.
+class rng_ {
+  static constexpr std::uint64_t gamma = 0x9e3779b97f4a7c15ULL;
 
-  std::size_t fails_{};
+ public:
+  using result_type = std::uint64_t;
 
-  TPrinter printer_{};
-};
+  constexpr explicit rng_(const std::uint64_t key) : key_{key} {}
 
-template <class TPrinter = printer>
-class reporter_junit {
-  template <typename Key, typename T>
-  using map = std::unordered_map<Key, T>;
-  using clock_ref = std::chrono::high_resolution_clock;
-  using timePoint = std::chrono::time_point<clock_ref>;
-  using timeDiff = std::chrono::milliseconds;
-  enum class ReportType : std::uint8_t { CONSOLE, JUNIT } report_type_;
-  static constexpr ReportType CONSOLE = ReportType::CONSOLE;
-  static constexpr ReportType JUNIT = ReportType::JUNIT;
+  [[nodiscard]] static constexpr auto min() -> result_type { return 0; }
+  [[nodiscard]] static constexpr auto max() -> result_type {
+    return ~result_type{};
+  }
 
-  struct test_result {
-    test_result* parent = nullptr;
-    std::string class_name;
-    std::string suite_name;
-    std::string test_name;
-    std::string status = "STARTED";
-    timePoint run_start = clock_ref::now();
-    timePoint run_stop = clock_ref::now();
-    std::size_t n_tests = 0LU;
-    std::size_t assertions = 0LU;
-    std::size_t passed = 0LU;
-    std::size_t skipped = 0LU;
-    std::size_t fails = 0LU;
-    std::string report_string{};
-    std::unique_ptr<map<std::string, test_result>> nested_tests =
-        std::make_unique<map<std::string, test_result>>();
-  };
-  colors color_{};
-  map<std::string, test_result> results_;
-  std::string active_suite_{"global"};
-  test_result* active_scope_ = &results_[active_suite_];
-  std::stack<std::string> active_test_{};
+  constexpr auto operator()() -> result_type {
+    return mix(key_ + ++counter_ * gamma);
+  }
+  constexpr auto discard(const unsigned long long n) -> void { counter_ += n; }
 
-  std::streambuf* cout_save = std::cout.rdbuf();
-  std::ostream lcout_;
-  TPrinter printer_;
-  std::stringstream ss_out_{};
+  [[nodiscard]] static constexpr auto mix(std::uint64_t z) -> std::uint64_t {
+    z = (z ^ (z >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27U)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31U);
+  }
 
-  void reset_printer() {
-    ss_out_.str("");
-    ss_out_.clear();
+  /// key of a test named `name` nested in the test with key `parent`
+  [[nodiscard]] static constexpr auto nested(std::uint64_t parent,
+                                             std::string_view name)
+      -> std::uint64_t {
+    auto hash = 0xcbf29ce484222325ULL;  // FNV-1a
+    for (const auto c : name) {
+      hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+    }
+    return mix(parent + gamma) ^ hash;
   }
 
-  void check_for_scope(std::string_view test_name) {
-    const std::string str_name(test_name);
-    active_test_.push(str_name);
-    const auto [iter, inserted] = active_scope_->nested_tests->try_emplace(
-        str_name, test_result{active_scope_, detail::cfg::executable_name,
-                              active_suite_, str_name});
-    active_scope_ = &active_scope_->nested_tests->at(str_name);
-    if (active_test_.size() == 1) {
-      reset_printer();
+  /// --rng-seed or, if not given, a time based seed fixed for the run
+  [[nodiscard]] static auto seed() -> std::uint64_t {
+    static const auto time = static_cast<std::uint64_t>(
+        std::chrono::system_clock::now().time_since_epoch().count());
+    return cfg::rnd_seed ? cfg::rnd_seed : time;
+  }
+
+  /// key of the running test, only set on the threads running it
+  static inline thread_local std::uint64_t path{};
+  static inline std::atomic<bool> used{};
+
+ private:
+  std::uint64_t key_{};
+  std::uint64_t counter_{};
+};
+
+/// rows of value indices (one per dimension of the given sizes) containing
+/// every combination of values of any `t` dimensions at least once, built
+/// greedily (AETG-like), each row starting with an uncovered combination
+[[nodiscard]] constexpr auto covering_array(const std::vector<std::size_t>& sizes,
+                                            std::size_t t)
+    -> std::vector<std::vector<std::size_t>> {
+  const auto k = sizes.size();
+  t = t < k ? t : k;
+  auto rows = std::vector<std::vector<std::size_t>>{};
+  if (not t or std::find(sizes.cbegin(), sizes.cend(), 0u) != sizes.cend()) {
+    return rows;
+  }
+
+  auto combinations = std::vector<std::vector<std::size_t>>{};  // of t dims
+  auto c = std::vector<std::size_t>(t);
+  for (auto i = 0u; i < t; ++i) {
+    c[i] = i;
+  }
+  for (;;) {
+    combinations.push_back(c);
+    auto i = t;
+    while (i and c[i - 1] == k - t + i - 1) {
+      --i;
     }
-    active_scope_->run_start = clock_ref::now();
-    if (!inserted) {
-      std::cout << "WARNING test '" << str_name << "' for test suite '"
-                << active_suite_ << "' already present\n";
+    if (not i) {
+      break;
+    }
+    ++c[i - 1];
+    for (auto j = i; j < t; ++j) {
+      c[j] = c[j - 1] + 1;
     }
   }
 
-  void pop_scope(std::string_view test_name_sv) {
-    const std::string test_name(test_name_sv);
-    active_scope_->run_stop = clock_ref::now();
-    if (active_scope_->skipped) {
-      active_scope_->status = "SKIPPED";
-    } else {
-      active_scope_->status = active_scope_->fails > 0 ? "FAILED" : "PASSED";
+  auto uncovered = std::vector<std::vector<char>>{};
+  auto remaining = std::size_t{};
+  for (const auto& dims : combinations) {
+    auto size = std::size_t{1};
+    for (const auto dim : dims) {
+      size *= sizes[dim];
     }
-    active_scope_->assertions =
-        active_scope_->assertions + active_scope_->fails;
+    uncovered.emplace_back(size, char{1});
+    remaining += size;
+  }
 
-    if (active_test_.top() == test_name) {
-      active_test_.pop();
+  auto row = std::vector<std::size_t>(k);
+  auto assigned = std::vector<char>(k);
+  const auto offset = [&](const std::vector<std::size_t>& dims) {
+    auto o = std::size_t{};
+    for (const auto dim : dims) {
+      o = o * sizes[dim] + row[dim];
+    }
+    return o;
+  };
+  while (remaining) {
+    std::fill(assigned.begin(), assigned.end(), char{});
+    for (auto i = 0u; i < combinations.size(); ++i) {
+      const auto first = std::find(uncovered[i].cbegin(), uncovered[i].cend(), 1);
+      if (first != uncovered[i].cend()) {
+        auto o = static_cast<std::size_t>(first - uncovered[i].cbegin());
+        for (auto j = t; j--;) {
+          const auto dim = combinations[i][j];
+          row[dim] = o % sizes[dim];
+          o /= sizes[dim];
+          assigned[dim] = 1;
+        }
+        break;
+      }
+    }
+    for (auto dim = 0u; dim < k; ++dim) {
+      if (assigned[dim]) {
+        continue;
+      }
+      assigned[dim] = 1;
+      auto best = std::pair{std::size_t{}, std::size_t{}};  // score, value
+      for (auto value = 0u; value < sizes[dim]; ++value) {
+        row[dim] = value;
+        auto score = std::size_t{};
+        for (auto i = 0u; i < combinations.size(); ++i) {
+          const auto& dims = combinations[i];
+          if (std::find(dims.cbegin(), dims.cend(), dim) != dims.cend() and
+              std::all_of(dims.cbegin(), dims.cend(),
+                          [&](const auto d) { return assigned[d]; })) {
+            score += static_cast<std::size_t>(uncovered[i][offset(dims)]);
+          }
+        }
+        if (score > best.first) {
+          best = {score, value};
+        }
+      }
+      row[dim] = best.second;
+    }
+    for (auto i = 0u; i < combinations.size(); ++i) {
+      if (auto& covered = uncovered[i][offset(combinations[i])]; covered) {
+        covered = 0;
+        --remaining;
+      }
+    }
+    rows.push_back(row);
+  }
+  return rows;
+}
+
+template <std::size_t T, class... TDims>
+inline constexpr auto covering_rows = [] {
+  constexpr auto count =
+      covering_array({std::tuple_size_v<TDims>...}, T).size();
+  auto rows = std::array<std::array<std::size_t, sizeof...(TDims)>, count>{};
+  const auto array = covering_array({std::tuple_size_v<TDims>...}, T);
+  for (auto r = 0u; r < count; ++r) {
+    std::copy(array[r].cbegin(), array[r].cend(), rows[r].begin());
+  }
+  return rows;
+}();
+
+/// the type dimensions (std::tuple<Ts...>) covered `T`-wise, as a tuple of
+/// std::tuple<T1, T2, ...> (one per row) for the `operator|` of types
+template <std::size_t T, class... TDims, std::size_t... Rs, std::size_t... Ds>
+[[nodiscard]] constexpr auto covering_types(std::index_sequence<Rs...>,
+                                            std::index_sequence<Ds...> dims) {
+  constexpr auto row = []<std::size_t R>(std::index_sequence<Ds...>) {
+    return std::tuple<std::tuple_element_t<covering_rows<T, TDims...>[R][Ds],
+                                           TDims>...>{};
+  };
+  return std::tuple<decltype(row.template operator()<Rs>(dims))...>{};
+}
+
+/// the value dimensions (ranges) covered `t`-wise (all of them if t >= size)
+template <class... TDims>
+[[nodiscard]] auto covering_values(const std::size_t t, const TDims&... dims)
+    -> std::vector<std::tuple<std::ranges::range_value_t<TDims>...>> {
+  const auto values = std::tuple{std::vector<std::ranges::range_value_t<TDims>>(
+      std::ranges::begin(dims), std::ranges::end(dims))...};
+  auto rows = std::vector<std::tuple<std::ranges::range_value_t<TDims>...>>{};
+  for (const auto& row : covering_array(
+           {static_cast<std::size_t>(std::ranges::distance(dims))...}, t)) {
+    rows.push_back([&]<std::size_t... Ds>(std::index_sequence<Ds...>) {
+      return std::tuple<std::ranges::range_value_t<TDims>...>{
+          std::get<Ds>(values)[row[Ds]]...};
+    }(std::index_sequence_for<TDims...>{}));
+  }
+  return rows;
+}
+
+/// the Cartesian product of value dimensions (ranges), computed on access
+template <class... TDims>
+class product_ {
+ public:
+  using value_type = std::tuple<std::ranges::range_value_t<TDims>...>;
+
+  class iterator {
+   public:
+    using difference_type = std::ptrdiff_t;
+    using value_type = product_::value_type;
+
+    iterator() = default;
+    iterator(const product_* product, const std::size_t index)
+        : product_ptr_{product}, index_{index} {}
+
+    [[nodiscard]] auto operator*() const -> value_type {
+      return (*product_ptr_)[index_];
+    }
+    auto operator++() -> iterator& {
+      ++index_;
+      return *this;
+    }
+    auto operator++(int) -> iterator {
+      auto it = *this;
+      ++index_;
+      return it;
+    }
+    [[nodiscard]] auto operator==(const iterator& other) const -> bool {
+      return index_ == other.index_;
+    }
+
+   private:
+    const product_* product_ptr_{};
+    std::size_t index_{};
+  };
+
+  explicit product_(const TDims&... dims)
+      : values_{std::vector<std::ranges::range_value_t<TDims>>(
+            std::ranges::begin(dims), std::ranges::end(dims))...} {}
+
+  [[nodiscard]] auto size() const -> std::size_t {
+    return std::apply(
+        [](const auto&... values) { return (std::size_t{1} * ... * values.size()); },
+        values_);
+  }
+
+  /// the last dimension varies fastest
+  [[nodiscard]] auto operator[](std::size_t index) const -> value_type {
+    auto indices = std::array<std::size_t, sizeof...(TDims)>{};
+    [&]<std::size_t... Ds>(std::index_sequence<Ds...>) {
+      constexpr auto last = sizeof...(TDims) - 1;
+      ((indices[last - Ds] = index % std::get<last - Ds>(values_).size(),
+        index /= std::get<last - Ds>(values_).size()),
+       ...);
+    }(std::index_sequence_for<TDims...>{});
+    return [&]<std::size_t... Ds>(std::index_sequence<Ds...>) {
+      return value_type{std::get<Ds>(values_)[indices[Ds]]...};
+    }(std::index_sequence_for<TDims...>{});
+  }
+
+  [[nodiscard]] auto begin() const { return iterator{this, 0}; }
+  [[nodiscard]] auto end() const { return iterator{this, size()}; }
+
+ private:
+  std::tuple<std::vector<std::ranges::range_value_t<TDims>>...> values_{};
+};
+
+template <std::size_t T, class... TDims>
+[[nodiscard]] constexpr auto t_wise(const TDims&... dims) {
+  static_assert(T > 0 and sizeof...(TDims) > 0);
+  if constexpr ((std::ranges::range<TDims> and ...)) {
+    return covering_values(T, dims...);
+  } else {
+    static_assert((requires { std::tuple_size<TDims>::value; } and ...),
+                  "dimensions are either all ranges (values) or all "
+                  "std::tuple<Ts...> (types)");
+    return covering_types<T, TDims...>(
+        std::make_index_sequence<covering_rows<T, TDims...>.size()>{},
+        std::index_sequence_for<TDims...>{});
+  }
+}
+
+template <class T>
+[[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto get_impl(const T& t, int)
+    -> decltype(t.get()) {
+  return t.get();
+}
+template <class T>
+[[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto get_impl(const T& t, ...)
+    -> decltype(auto) {
+  return t;
+}
+template <class T>
+[[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto get(const T& t) {
+  return get_impl(t, 0);
+}
+
+template <class T>
+struct type_ : op {
+  template <class TOther>
+  // NOLINTNEXTLINE(readability-const-return-type)
+  [[nodiscard]] constexpr auto operator()(const TOther&) const
+      -> const type_<TOther> {
+    return {};
+  }
+  [[nodiscard]] constexpr auto operator==(type_<T>) -> bool { return true; }
+  template <class TOther>
+  [[nodiscard]] constexpr auto operator==(type_<TOther>) -> bool {
+    return false;
+  }
+  template <class TOther>
+  [[nodiscard]] constexpr auto operator==(const TOther&) -> bool {
+    return std::is_same_v<TOther, T>;
+  }
+  [[nodiscard]] constexpr auto operator!=(type_<T>) -> bool { return false; }
+  template <class TOther>
+  [[nodiscard]] constexpr auto operator!=(type_<TOther>) -> bool {
+    return true;
+  }
+  template <class TOther>
+  [[nodiscard]] constexpr auto operator!=(const TOther&) -> bool {
+    return not std::is_same_v<TOther, T>;
+  }
+};
+
+template <class T, class = int>
+struct value : op {
+  using value_type = T;
+
+  BOOST_UT_ALWAYS_INLINE constexpr /*explicit(false)*/ value(const T& _value)
+      : value_{_value} {}
+  [[nodiscard]] constexpr explicit operator T() const { return value_; }
+  [[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr decltype(auto) get() const {
+    return value_;
+  }
+
+  T value_{};
+};
+
+template <std::floating_point T>
+struct value<T> : op {
+  using value_type = T;
+  static inline auto epsilon = T{};
+
+  constexpr value(const T& _value, const T precision) : value_{_value} {
+    epsilon = precision;
+  }
+
+  constexpr /*explicit(false)*/ value(const T& val)
+      : value{val, T(1) / math::pow(T(10),
+                                    math::den_size<unsigned long long>(val))} {}
+  [[nodiscard]] constexpr explicit operator T() const { return value_; }
+  [[nodiscard]] constexpr decltype(auto) get() const { return value_; }
+
+  T value_{};
+};
+
+template <class T>
+class value_location : public detail::value<T> {
+ public:
+  constexpr /*explicit(false)*/ value_location(
+      const T& t, const reflection::source_location& sl =
+                      reflection::source_location::current())
+      : detail::value<T>{t} {
+    cfg::location = sl;
+  }
+
+  constexpr value_location(const T& t, const T precision,
+                           const reflection::source_location& sl =
+                               reflection::source_location::current())
+      : detail::value<T>{t, precision} {
+    cfg::location = sl;
+  }
+};
+
+template <auto N>
+struct integral_constant : op {
+  using value_type = decltype(N);
+  static constexpr auto value = N;
+
+  [[nodiscard]] constexpr auto operator-() const {
+    return integral_constant<-N>{};
+  }
+  [[nodiscard]] constexpr explicit operator value_type() const { return N; }
+  [[nodiscard]] constexpr auto get() const { return N; }
+};
+
+template <class T, auto N, auto D, auto Size, auto P = 1>
+struct floating_point_constant : op {
+  using value_type = T;
+
+  static constexpr auto epsilon = T(1) / math::pow(T(10), Size - 1);
+  static constexpr auto value = T(P) * (T(N) + (T(D) / math::pow(T(10), Size)));
+
+  [[nodiscard]] constexpr auto operator-() const {
+    return floating_point_constant<T, N, D, Size, -1>{};
+  }
+  [[nodiscard]] constexpr explicit operator value_type() const { return value; }
+  [[nodiscard]] constexpr auto get() const { return value; }
+};
+
+template <class TLhs, class TRhs>
+struct eq_ : op {
+  BOOST_UT_ALWAYS_INLINE constexpr eq_(const TLhs& lhs = {},
+                                       const TRhs& rhs = {})
+      : lhs_{lhs}, rhs_{rhs}, value_{[&]() BOOST_UT_ALWAYS_INLINE {
+          using std::operator==;
+          using std::operator<;
+
+          if constexpr (type_traits::has_static_member_object_value_v<TLhs> and
+                        type_traits::has_static_member_object_value_v<TRhs>) {
+            return lhs.value == rhs.value;
+          } else if constexpr (type_traits::has_static_member_object_epsilon_v<
+                                   TLhs> and
+                               type_traits::has_static_member_object_epsilon_v<
+                                   TRhs>) {
+            return math::abs(get(lhs) - get(rhs)) <
+                   math::min_value(TLhs::epsilon, TRhs::epsilon);
+          } else if constexpr (type_traits::has_static_member_object_epsilon_v<
+                                   TLhs>) {
+            return math::abs(get(lhs) - get(rhs)) < TLhs::epsilon;
+          } else if constexpr (type_traits::has_static_member_object_epsilon_v<
+                                   TRhs>) {
+            return math::abs(get(lhs) - get(rhs)) < TRhs::epsilon;
+          } else {
+            return get(lhs) == get(rhs);
+          }
+        }()} {}
+
+  [[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr operator bool() const {
+    return value_;
+  }
+  [[nodiscard]] constexpr auto lhs() const { return get(lhs_); }
+  [[nodiscard]] constexpr auto rhs() const { return get(rhs_); }
+
+  const TLhs lhs_{};
+  const TRhs rhs_{};
+  const bool value_{};
+};
+
+template <class TLhs, class TRhs, class TEpsilon>
+struct approx_ : op {
+  BOOST_UT_ALWAYS_INLINE constexpr approx_(const TLhs& lhs = {},
+                                           const TRhs& rhs = {},
+                                           const TEpsilon& epsilon = {})
+      : lhs_{lhs},
+        rhs_{rhs},
+        epsilon_{epsilon},
+        value_{[&]() BOOST_UT_ALWAYS_INLINE {
+          using std::operator<;
+
+          if constexpr (type_traits::has_static_member_object_value_v<TLhs> and
+                        type_traits::has_static_member_object_value_v<TRhs> and
+                        type_traits::has_static_member_object_value_v<
+                            TEpsilon>) {
+            return math::abs_diff(TLhs::value, TRhs::value) < TEpsilon::value;
+          } else {
+            return math::abs_diff(get(lhs), get(rhs)) < get(epsilon);
+          }
+        }()} {}
+
+  [[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr operator bool() const {
+    return value_;
+  }
+  [[nodiscard]] constexpr auto lhs() const { return get(lhs_); }
+  [[nodiscard]] constexpr auto rhs() const { return get(rhs_); }
+  [[nodiscard]] constexpr auto epsilon() const { return get(epsilon_); }
+
+  const TLhs lhs_{};
+  const TRhs rhs_{};
+  const TEpsilon epsilon_{};
+  const bool value_{};
+};
+
+template <class TLhs, class TRhs>
+struct neq_ : op {
+  BOOST_UT_ALWAYS_INLINE constexpr neq_(const TLhs& lhs = {},
+                                        const TRhs& rhs = {})
+      : lhs_{lhs}, rhs_{rhs}, value_{[&]() BOOST_UT_ALWAYS_INLINE {
+          using std::operator==;
+          using std::operator!=;
+          using std::operator>;
+
+          if constexpr (type_traits::has_static_member_object_value_v<TLhs> and
+                        type_traits::has_static_member_object_value_v<TRhs>) {
+            return lhs.value != rhs.value;
+          } else if constexpr (type_traits::has_static_member_object_epsilon_v<
+                                   TLhs> and
+                               type_traits::has_static_member_object_epsilon_v<
+                                   TRhs>) {
+            return math::abs(get(lhs_) - get(rhs_)) >
+                   math::min_value(TLhs::epsilon, TRhs::epsilon);
+          } else if constexpr (type_traits::has_static_member_object_epsilon_v<
+                                   TLhs>) {
+            return math::abs(get(lhs_) - get(rhs_)) > TLhs::epsilon;
+          } else if constexpr (type_traits::has_static_member_object_epsilon_v<
+                                   TRhs>) {
+            return math::abs(get(lhs_) - get(rhs_)) > TRhs::epsilon;
+          } else {
+            return get(lhs_) != get(rhs_);
+          }
+        }()} {}
+
+  [[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr operator bool() const {
+    return value_;
+  }
+  [[nodiscard]] constexpr auto lhs() const { return get(lhs_); }
+  [[nodiscard]] constexpr auto rhs() const { return get(rhs_); }
+
+  const TLhs lhs_{};
+  const TRhs rhs_{};
+  const bool value_{};
+};
+
+template <class TLhs, class TRhs>
+struct gt_ : op {
+  BOOST_UT_ALWAYS_INLINE constexpr gt_(const TLhs& lhs = {},
+                                       const TRhs& rhs = {})
+      : lhs_{lhs}, rhs_{rhs}, value_{[&]() BOOST_UT_ALWAYS_INLINE {
+          using std::operator>;
+
+          if constexpr (type_traits::has_static_member_object_value_v<TLhs> and
+                        type_traits::has_static_member_object_value_v<TRhs>) {
+            return lhs.value > rhs.value;
+          } else {
+            return get(lhs_) > get(rhs_);
+          }
+        }()} {}
+
+  [[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr operator bool() const {
+    return value_;
+  }
+  [[nodiscard]] constexpr auto lhs() const { return get(lhs_); }
+  [[nodiscard]] constexpr auto rhs() const { return get(rhs_); }
+
+  const TLhs lhs_{};
+  const TRhs rhs_{};
+  const bool value_{};
+};
+
+template <class TLhs, class TRhs>
+struct ge_ : op {
+  BOOST_UT_ALWAYS_INLINE constexpr ge_(const TLhs& lhs = {},
+                                       const TRhs& rhs = {})
+      : lhs_{lhs}, rhs_{rhs}, value_{[&]() BOOST_UT_ALWAYS_INLINE {
+          using std::operator>=;
+
+          if constexpr (type_traits::has_static_member_object_value_v<TLhs> and
+                        type_traits::has_static_member_object_value_v<TRhs>) {
+            return lhs.value >= rhs.value;
+          } else {
+            return get(lhs_) >= get(rhs_);
+          }
+        }()} {}
+
+  [[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr operator bool() const {
+    return value_;
+  }
+  [[nodiscard]] constexpr auto lhs() const { return get(lhs_); }
+  [[nodiscard]] constexpr auto rhs() const { return get(rhs_); }
+
+  const TLhs lhs_{};
+  const TRhs rhs_{};
+  const bool value_{};
+};
+
+template <class TLhs, class TRhs>
+struct lt_ : op {
+  BOOST_UT_ALWAYS_INLINE constexpr lt_(const TLhs& lhs = {},
+                                       const TRhs& rhs = {})
+      : lhs_{lhs}, rhs_{rhs}, value_{[&]() BOOST_UT_ALWAYS_INLINE {
+          using std::operator<;
+
+          if constexpr (type_traits::has_static_member_object_value_v<TLhs> and
+                        type_traits::has_static_member_object_value_v<TRhs>) {
+#if defined(_MSC_VER) && !defined(__clang__)
+            // for some reason, accessing the static member via :: does not compile on MSVC,
+            // and the next line does not compile on clang, so we have to use the ifdef here
+            return lhs.value < rhs.value;
+#else
+            return TLhs::value < TRhs::value;
+#endif
+          } else {
+            return get(lhs_) < get(rhs_);
+          }
+        }()} {
+  }
+
+  [[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr operator bool() const {
+    return value_;
+  }
+  [[nodiscard]] constexpr auto lhs() const { return get(lhs_); }
+  [[nodiscard]] constexpr auto rhs() const { return get(rhs_); }
+
+ private:
+  const TLhs lhs_{};
+  const TRhs rhs_{};
+  const bool value_{};
+};
+
+template <class TLhs, class TRhs>
+struct le_ : op {
+  BOOST_UT_ALWAYS_INLINE constexpr le_(const TLhs& lhs = {},
+                                       const TRhs& rhs = {})
+      : lhs_{lhs}, rhs_{rhs}, value_{[&]() BOOST_UT_ALWAYS_INLINE {
+          using std::operator<=;
+
+          if constexpr (type_traits::has_static_member_object_value_v<TLhs> and
+                        type_traits::has_static_member_object_value_v<TRhs>) {
+            return lhs.value <= rhs.value;
+          } else {
+            return get(lhs_) <= get(rhs_);
+          }
+        }()} {}
+
+  [[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr operator bool() const {
+    return value_;
+  }
+  [[nodiscard]] constexpr auto lhs() const { return get(lhs_); }
+  [[nodiscard]] constexpr auto rhs() const { return get(rhs_); }
+
+  const TLhs lhs_{};
+  const TRhs rhs_{};
+  const bool value_{};
+};
+
+template <class TLhs, class TRhs>
+struct and_ : op {
+  BOOST_UT_ALWAYS_INLINE constexpr and_(const TLhs& lhs = {},
+                                        const TRhs& rhs = {})
+      : lhs_{lhs},
+        rhs_{rhs},
+        value_{static_cast<bool>(lhs) and static_cast<bool>(rhs)} {}
+
+  [[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr operator bool() const {
+    return value_;
+  }
+  [[nodiscard]] constexpr auto lhs() const { return get(lhs_); }
+  [[nodiscard]] constexpr auto rhs() const { return get(rhs_); }
+
+  const TLhs lhs_{};
+  const TRhs rhs_{};
+  const bool value_{};
+};
+
+template <class TLhs, class TRhs>
+struct or_ : op {
+  BOOST_UT_ALWAYS_INLINE constexpr or_(const TLhs& lhs = {},
+                                       const TRhs& rhs = {})
+      : lhs_{lhs},
+        rhs_{rhs},
+        value_{static_cast<bool>(lhs) or static_cast<bool>(rhs)} {}
+
+  [[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr operator bool() const {
+    return value_;
+  }
+  [[nodiscard]] constexpr auto lhs() const { return get(lhs_); }
+  [[nodiscard]] constexpr auto rhs() const { return get(rhs_); }
+
+  const TLhs lhs_{};
+  const TRhs rhs_{};
+  const bool value_{};
+};
+
+template <class T>
+struct not_ : op {
+  BOOST_UT_ALWAYS_INLINE explicit constexpr not_(const T& t = {})
+      : t_{t}, value_{not static_cast<bool>(t)} {}
+
+  [[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr operator bool() const {
+    return value_;
+  }
+  [[nodiscard]] constexpr auto value() const { return get(t_); }
+
+  const T t_{};
+  const bool value_{};
+};
+
+template <class>
+struct fatal_;
+
+#if defined(__cpp_exceptions)
+template <class TExpr, class TException = void>
+struct throws_ : op {
+  constexpr explicit throws_(const TExpr& expr)
+      : value_{[&expr] {
+          try {
+            expr();
+            return false;
+          } catch (const TException&) {
+            return true;
+          } catch (...) {
+            return false;
+          }
+        }()} {}
+
+  [[nodiscard]] constexpr operator bool() const { return value_; }
+
+  const bool value_{};
+};
+
+template <class TExpr>
+struct throws_<TExpr, void> : op {
+  constexpr explicit throws_(const TExpr& expr)
+      : value_{[&expr] {
+          try {
+            expr();
+            return false;
+          } catch (...) {
+            return true;
+          }
+        }()} {}
+
+  [[nodiscard]] constexpr operator bool() const { return value_; }
+
+  const bool value_{};
+};
+
+template <class TExpr>
+struct nothrow_ : op {
+  constexpr explicit nothrow_(const TExpr& expr)
+      : value_{[&expr] {
+          try {
+            expr();
+            return true;
+          } catch (...) {
+            return false;
+          }
+        }()} {}
+
+  [[nodiscard]] constexpr operator bool() const { return value_; }
+
+  const bool value_{};
+};
+#endif
+
+#if __has_include(<unistd.h>) and __has_include(<sys/wait.h>)
+template <class TExpr>
+struct aborts_ : op {
+  constexpr explicit aborts_(const TExpr& expr)
+      : value_{[&expr]() -> bool {
+          if (const auto pid = fork(); not pid) {
+            expr();
+            std::exit(0);
+          }
+          auto exit_status = 0;
+          wait(&exit_status);
+          return exit_status;
+        }()} {}
+
+  [[nodiscard]] constexpr operator bool() const { return value_; }
+
+  const bool value_{};
+};
+#endif
+
+/// heap allocations of the current thread, counted by the operator new
+/// replacements defined with BOOST_UT_ALLOC_HOOKS
+struct allocations {
+  static inline std::atomic<bool> hooked{};
+  static inline thread_local bool tracking{};
+  static inline thread_local std::size_t count{};
+  static inline thread_local std::size_t limit{};
+  static inline thread_local std::array<void*, 16> stack{};
+  static inline thread_local int depth{};
+
+  /// stops counting while the framework reports events
+  struct pause {
+    BOOST_UT_ALWAYS_INLINE pause() : tracking{allocations::tracking} {
+      if (tracking) {
+        allocations::tracking = false;
+      }
+    }
+    BOOST_UT_ALWAYS_INLINE constexpr ~pause() {
+      if (tracking) {
+        allocations::tracking = true;
+      }
+    }
+    bool tracking{};
+  };
+
+  static auto on_allocation() -> void {
+    if (tracking and ++count == limit + 1) {
+#if __has_include(<execinfo.h>)
+      tracking = false;
+      depth = ::backtrace(stack.data(), static_cast<int>(stack.size()));
+      tracking = true;
+#endif
+    }
+  }
+};
+
+template <class TExpr>
+struct allocs_ : op {
+  allocs_(const TExpr& expr, const std::size_t limit) : limit_{limit} {
+#if __has_include(<execinfo.h>)
+    [[maybe_unused]] static const auto loaded = [] {  // backtrace allocates once
+      auto* frame = static_cast<void*>(nullptr);
+      return ::backtrace(&frame, 1);
+    }();
+#endif
+    struct scope {
+      bool tracking{std::exchange(allocations::tracking, true)};
+      std::size_t count{std::exchange(allocations::count, 0)};
+      std::size_t limit{};
+      allocs_& self;
+
+      scope(allocs_& s) : limit{std::exchange(allocations::limit, s.limit_)}, self{s} {
+        allocations::depth = 0;
+      }
+      ~scope() {
+        allocations::tracking = tracking;
+        self.count_ = std::exchange(allocations::count, count + allocations::count);
+        allocations::limit = limit;
+      }
+    };
+    {
+      const scope guard{*this};
+      expr();
+    }
+#if __has_include(<execinfo.h>)
+    if (count_ > limit_ and allocations::depth) {
+      auto* symbols = ::backtrace_symbols(allocations::stack.data(), allocations::depth);
+      for (auto i = 0; symbols and i < allocations::depth; ++i) {
+        stack_.emplace_back(symbols[i]);
+      }
+      std::free(symbols);
+    }
+#endif
+  }
+
+  [[nodiscard]] operator bool() const {
+    return allocations::hooked and count_ <= limit_;
+  }
+  [[nodiscard]] auto limit() const { return limit_; }
+  [[nodiscard]] auto count() const { return count_; }
+  /// where the first allocation over the limit happened, if known
+  [[nodiscard]] auto stack() const -> const std::vector<std::string>& {
+    return stack_;
+  }
+
+ private:
+  std::size_t limit_{};
+  std::size_t count_{};
+  std::vector<std::string> stack_{};
+};
+
+/// wakes up eventually() waiting on it, signalled by the code under test
+class notifier {
+ public:
+  auto notify() -> void {
+    {
+      const std::scoped_lock lock{mutex_};
+      ++generation_;
+    }
+    changed_.notify_all();
+  }
+
+  [[nodiscard]] auto generation() -> std::uint64_t {
+    const std::scoped_lock lock{mutex_};
+    return generation_;
+  }
+
+  /// waits until notified after `seen` (returns true) or the timeout
+  template <class TRep, class TPeriod>
+  auto wait_for(const std::uint64_t seen,
+                const std::chrono::duration<TRep, TPeriod>& timeout) -> bool {
+    std::unique_lock lock{mutex_};
+    return changed_.wait_for(lock, timeout,
+                             [&] { return generation_ != seen; });
+  }
+
+ private:
+  std::mutex mutex_{};
+  std::condition_variable changed_{};
+  std::uint64_t generation_{};
+};
+
+template <class TPred>
+struct eventually_ : op {
+  using value_type = std::remove_cvref_t<std::invoke_result_t<const TPred&>>;
+  using clock = std::chrono::steady_clock;
+
+  eventually_(const TPred& pred, const clock::duration timeout,
+              notifier* wakeup = nullptr) {
+    const auto start = clock::now();
+    const auto deadline = start + timeout;
+    auto delay = clock::duration{std::chrono::microseconds{1}};
+    for (;;) {
+      const auto seen = wakeup ? wakeup->generation() : 0;
+      ++checks_;
+      last_.emplace(pred());
+      if (static_cast<bool>(*last_) or clock::now() >= deadline) {
+        break;
+      }
+      const auto wait = std::min(delay, deadline - clock::now());
+      if (wakeup) {
+        void(wakeup->wait_for(seen, wait));
+      } else {
+        std::this_thread::sleep_for(wait);
+      }
+      delay = std::min<clock::duration>(delay * 2, std::chrono::milliseconds{10});
+    }
+    elapsed_ = clock::now() - start;
+  }
+
+  [[nodiscard]] operator bool() const { return static_cast<bool>(*last_); }
+  /// the result of the last check
+  [[nodiscard]] auto last() const -> const value_type& { return *last_; }
+  [[nodiscard]] auto checks() const { return checks_; }
+  [[nodiscard]] auto elapsed() const { return elapsed_; }
+
+ private:
+  std::optional<value_type> last_{};
+  std::size_t checks_{};
+  clock::duration elapsed_{};
+};
+}  // namespace detail
+
+namespace type_traits {
+template <class T>
+concept is_op = std::derived_from<T, detail::op>;
+
+template <typename T, typename = void>
+struct is_stream_insertable : std::false_type {};
+
+template <typename T>
+struct is_stream_insertable<
+    T, std::void_t<decltype(std::declval<std::ostream&>()
+                            << detail::get(std::declval<T>()))>>
+    : std::true_type {};
+template <typename T>
+inline constexpr bool is_stream_insertable_v = is_stream_insertable<T>::value;
+}  // namespace type_traits
+
+struct colors {
+  std::string_view none = "\033[0m";
+  std::string_view pass = "\033[32m";
+  std::string_view fail = "\033[31m";
+  std::string_view skip = "\033[33m";
+};
+
+class printer {
+  [[nodiscard]] auto color(const bool cond) {
+    return cond ? colors_.pass : colors_.fail;
+  }
+
+ public:
+  printer() = default;
+  /*explicit(false)*/ printer(const colors colors) : colors_{colors} {}
+
+  template <class T>
+  auto& operator<<(const T& t) {
+    out_ << detail::get(t);
+    return *this;
+  }
+
+  template <class T>
+    requires std::ranges::range<T> && (!concepts::ostreamable<T>)
+  auto& operator<<(T&& t) {
+    *this << '{';
+    auto first = true;
+    for (const auto& arg : t) {
+      *this << (first ? "" : ", ") << arg;
+      first = false;
+    }
+    *this << '}';
+    return *this;
+  }
+
+  auto& operator<<(std::string_view sv) {
+    out_ << sv;
+    return *this;
+  }
+
+  template <class TLhs, class TRhs>
+  auto& operator<<(const detail::eq_<TLhs, TRhs>& op) {
+    return (*this << color(op) << op.lhs() << " == " << op.rhs()
+                  << colors_.none);
+  }
+
+  template <class TLhs, class TRhs, class TEpsilon>
+  auto& operator<<(const detail::approx_<TLhs, TRhs, TEpsilon>& op) {
+    return (*this << color(op) << op.lhs() << " ~ (" << op.rhs() << " +/- "
+                  << op.epsilon() << ')' << colors_.none);
+  }
+
+  template <class TLhs, class TRhs>
+  auto& operator<<(const detail::neq_<TLhs, TRhs>& op) {
+    return (*this << color(op) << op.lhs() << " != " << op.rhs()
+                  << colors_.none);
+  }
+
+  template <class TLhs, class TRhs>
+  auto& operator<<(const detail::gt_<TLhs, TRhs>& op) {
+    return (*this << color(op) << op.lhs() << " > " << op.rhs()
+                  << colors_.none);
+  }
+
+  template <class TLhs, class TRhs>
+  auto& operator<<(const detail::ge_<TLhs, TRhs>& op) {
+    return (*this << color(op) << op.lhs() << " >= " << op.rhs()
+                  << colors_.none);
+  }
+
+  template <class TLhs, class TRhs>
+  auto& operator<<(const detail::lt_<TRhs, TLhs>& op) {
+    return (*this << color(op) << op.lhs() << " < " << op.rhs()
+                  << colors_.none);
+  }
+
+  template <class TLhs, class TRhs>
+  auto& operator<<(const detail::le_<TRhs, TLhs>& op) {
+    return (*this << color(op) << op.lhs() << " <= " << op.rhs()
+                  << colors_.none);
+  }
+
+  template <class TLhs, class TRhs>
+  auto& operator<<(const detail::and_<TLhs, TRhs>& op) {
+    return (*this << '(' << op.lhs() << color(op) << " and " << colors_.none
+                  << op.rhs() << ')');
+  }
+
+  template <class TLhs, class TRhs>
+  auto& operator<<(const detail::or_<TLhs, TRhs>& op) {
+    return (*this << '(' << op.lhs() << color(op) << " or " << colors_.none
+                  << op.rhs() << ')');
+  }
+
+  template <class T>
+  auto& operator<<(const detail::not_<T>& op) {
+    return (*this << color(op) << "not " << op.value() << colors_.none);
+  }
+
+  template <class T>
+  auto& operator<<(const detail::fatal_<T>& fatal) {
+    return (*this << fatal.get());
+  }
+
+#if defined(__cpp_exceptions)
+  template <class TExpr, class TException>
+  auto& operator<<(const detail::throws_<TExpr, TException>& op) {
+    return (*this << color(op) << "throws<"
+                  << reflection::type_name<TException>() << ">"
+                  << colors_.none);
+  }
+
+  template <class TExpr>
+  auto& operator<<(const detail::throws_<TExpr, void>& op) {
+    return (*this << color(op) << "throws" << colors_.none);
+  }
+
+  template <class TExpr>
+  auto& operator<<(const detail::nothrow_<TExpr>& op) {
+    return (*this << color(op) << "nothrow" << colors_.none);
+  }
+#endif
+
+#if __has_include(<unistd.h>) and __has_include(<sys/wait.h>)
+  template <class TExpr>
+  auto& operator<<(const detail::aborts_<TExpr>& op) {
+    return (*this << color(op) << "aborts" << colors_.none);
+  }
+#endif
+
+  template <class TPred>
+  auto& operator<<(const detail::eventually_<TPred>& op) {
+    *this << color(op) << "eventually(";
+    if constexpr (std::is_same_v<typename detail::eventually_<TPred>::value_type,
+                                 bool>) {
+      *this << (op.last() ? "true" : "false");
+    } else {
+      *this << op.last();
+    }
+    *this << ')';
+    if (not op) {
+      *this << " after "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(
+                   op.elapsed())
+                   .count()
+            << "ms and " << op.checks() << " checks";
+    }
+    return (*this << colors_.none);
+  }
+
+  template <class TExpr>
+  auto& operator<<(const detail::allocs_<TExpr>& op) {
+    *this << color(op);
+    if (op.limit()) {
+      *this << "max_allocs(" << op.limit() << ')';
+    } else {
+      *this << "no_alloc";
+    }
+    if (not detail::allocations::hooked) {
+      *this << ": no allocation hooks (define BOOST_UT_ALLOC_HOOKS)";
+    } else if (not op) {
+      *this << ": " << op.count() << " allocations";
+      for (const auto& frame : op.stack()) {
+        *this << "\n    " << frame;
+      }
+    }
+    return (*this << colors_.none);
+  }
+
+  template <class T>
+  auto& operator<<(const detail::type_<T>&) {
+    return (*this << reflection::type_name<T>());
+  }
+
+  auto str() const { return out_.str(); }
+  const auto& colors() const { return colors_; }
+
+ private:
+  ut::colors colors_{};
+  std::ostringstream out_{};
+};
+
+template <class TPrinter = printer>
+class reporter {
+ public:
+  constexpr auto operator=(TPrinter printer) {
+    printer_ = static_cast<TPrinter&&>(printer);
+  }
+
+  auto on(events::run_begin) -> void {}
+
+  auto on(events::test_begin test_begin) -> void {
+    printer_ << "Running \"" << test_begin.name << "\"...";
+    fails_ = asserts_.fail;
+  }
+
+  auto on(events::test_run test_run) -> void {
+    printer_ << "\n \"" << test_run.name << "\"...";
+  }
+
+  auto on(events::test_skip test_skip) -> void {
+    printer_ << test_skip.name << "...SKIPPED\n";
+    ++tests_.skip;
+  }
+
+  auto on(events::test_end) -> void {
+    if (asserts_.fail > fails_) {
+      ++tests_.fail;
+      printer_ << '\n'
+               << printer_.colors().fail << "FAILED" << printer_.colors().none
+               << '\n';
+    } else {
+      ++tests_.pass;
+      printer_ << printer_.colors().pass << "PASSED" << printer_.colors().none
+               << '\n';
+    }
+  }
+
+  template <class TMsg>
+  auto on(events::log<TMsg> l) -> void {
+    printer_ << l.msg;
+  }
+
+  auto on(events::exception exception) -> void {
+    printer_ << "\n  " << printer_.colors().fail
+             << "Unexpected exception with message:\n"
+             << exception.what() << printer_.colors().none;
+    ++asserts_.fail;
+  }
+
+  template <class TExpr>
+  BOOST_UT_ALWAYS_INLINE auto on(events::assertion_pass<TExpr>) -> void {
+    ++asserts_.pass;
+  }
+
+  template <class TExpr>
+  auto on(events::assertion_fail<TExpr> assertion) -> void {
+    constexpr auto short_name = [](std::string_view name) {
+      return name.rfind('/') != std::string_view::npos
+                 ? name.substr(name.rfind('/') + 1)
+                 : name;
+    };
+    printer_ << "\n  " << short_name(assertion.location.file_name()) << ':'
+             << assertion.location.line() << ':' << printer_.colors().fail
+             << "FAILED" << printer_.colors().none << " [" << std::boolalpha
+             << assertion.expr << printer_.colors().none << ']';
+    ++asserts_.fail;
+  }
+
+  auto on(const events::fatal_assertion&) -> void {}
+
+  auto on(events::metric metric) -> void {
+    printer_ << "\n  " << metric.name << " = "
+             << detail::metrics::format(metric.value);
+  }
+
+  auto on(events::summary) -> void {
+    if (tests_.fail or asserts_.fail) {
+      printer_ << "\n========================================================"
+                  "=======================\n"
+               << "tests:   " << (tests_.pass + tests_.fail) << " | "
+               << printer_.colors().fail << tests_.fail << " failed"
+               << printer_.colors().none << '\n'
+               << "asserts: " << (asserts_.pass + asserts_.fail) << " | "
+               << asserts_.pass << " passed"
+               << " | " << printer_.colors().fail << asserts_.fail << " failed"
+               << printer_.colors().none << '\n';
+      std::cerr << printer_.str() << std::endl;
+    } else {
+      std::cout << printer_.colors().pass << "All tests passed"
+                << printer_.colors().none << " (" << asserts_.pass
+                << " asserts in " << tests_.pass << " tests)\n";
+
+      if (tests_.skip) {
+        std::cout << tests_.skip << " tests skipped\n";
+      }
+
+      std::cout.flush();
+    }
+  }
+
+ protected:
+  struct {
+    std::size_t pass{};
+    std::size_t fail{};
+    std::size_t skip{};
+  } tests_{};
+
+  struct {
+    std::size_t pass{};
+    std::size_t fail{};
+  } asserts_{};
+
+  std::size_t fails_{};
+
+  TPrinter printer_{};
+};
+
+template <class TPrinter = printer>
+class reporter_junit {
+  template <typename Key, typename T>
+  using map = std::unordered_map<Key, T>;
+  using clock_ref = std::chrono::high_resolution_clock;
+  using timePoint = std::chrono::time_point<clock_ref>;
+  using timeDiff = std::chrono::milliseconds;
+  enum class ReportType : std::uint8_t { CONSOLE, JUNIT } report_type_;
+  static constexpr ReportType CONSOLE = ReportType::CONSOLE;
+  static constexpr ReportType JUNIT = ReportType::JUNIT;
+
+  struct test_metric {
+    std::string name;
+    std::string_view kind;
+    double value{};
+  };
+
+  struct test_result {
+    test_result* parent = nullptr;
+    std::string class_name;
+    std::string suite_name;
+    std::string test_name;
+    std::string status = "STARTED";
+    timePoint run_start = clock_ref::now();
+    timePoint run_stop = clock_ref::now();
+    std::size_t n_tests = 0LU;
+    std::size_t assertions = 0LU;
+    std::size_t passed = 0LU;
+    std::size_t skipped = 0LU;
+    std::size_t fails = 0LU;
+    std::string report_string{};
+    std::vector<test_metric> metrics{};
+    std::unique_ptr<map<std::string, test_result>> nested_tests =
+        std::make_unique<map<std::string, test_result>>();
+  };
+  colors color_{};
+  map<std::string, test_result> results_;
+  std::string active_suite_{"global"};
+  test_result* active_scope_ = &results_[active_suite_];
+  std::stack<std::string> active_test_{};
+
+  std::streambuf* cout_save = std::cout.rdbuf();
+  std::ostream lcout_;
+  TPrinter printer_;
+  std::stringstream ss_out_{};
+
+  void reset_printer() {
+    ss_out_.str("");
+    ss_out_.clear();
+  }
+
+  void check_for_scope(std::string_view test_name) {
+    const std::string str_name(test_name);
+    active_test_.push(str_name);
+    const auto [iter, inserted] = active_scope_->nested_tests->try_emplace(
+        str_name, test_result{active_scope_, detail::cfg::executable_name,
+                              active_suite_, str_name});
+    active_scope_ = &active_scope_->nested_tests->at(str_name);
+    if (active_test_.size() == 1) {
+      reset_printer();
+    }
+    active_scope_->run_start = clock_ref::now();
+    if (!inserted) {
+      std::cout << "WARNING test '" << str_name << "' for test suite '"
+                << active_suite_ << "' already present\n";
+    }
+  }
+
+  void pop_scope(std::string_view test_name_sv) {
+    const std::string test_name(test_name_sv);
+    active_scope_->run_stop = clock_ref::now();
+    if (active_scope_->skipped) {
+      active_scope_->status = "SKIPPED";
+    } else {
+      active_scope_->status = active_scope_->fails > 0 ? "FAILED" : "PASSED";
+    }
+    active_scope_->assertions =
+        active_scope_->assertions + active_scope_->fails;
+
+    if (active_test_.top() == test_name) {
+      active_test_.pop();
       auto old_scope = active_scope_;
       if (active_scope_->parent != nullptr) {
         active_scope_ = active_scope_->parent;
       } else {
-        active_scope_ = &results_[std::string{"global"}];
+        active_scope_ = &results_[std::string{"global"}];
+      }
+      active_scope_->n_tests += old_scope->n_tests + 1LU;
+      active_scope_->assertions += old_scope->assertions;
+      active_scope_->passed += old_scope->passed;
+      active_scope_->skipped += old_scope->skipped;
+      active_scope_->fails += old_scope->fails;
+      return;
+    }
+    std::stringstream ss("runner returned from test w/o signaling: ");
+    ss << "not popping because '" << active_test_.top() << "' differs from '"
+       << test_name << "'" << std::endl;
+#if defined(__cpp_exceptions)
+    throw std::logic_error(ss.str());
+#else
+    std::abort();
+#endif
+  }
+
+ public:
+  constexpr auto operator=(TPrinter printer) {
+    printer_ = static_cast<TPrinter&&>(printer);
+  }
+  reporter_junit() : lcout_(std::cout.rdbuf()) {}
+  ~reporter_junit() { std::cout.rdbuf(cout_save); }
+
+  auto on(events::run_begin run) {
+    ::boost::ut::detail::cfg::parse_arg_with_fallback(run.argc, run.argv);
+
+    if (detail::cfg::show_reporters) {
+      std::cout << "available reporter:\n";
+      std::cout << "  console (default)\n";
+      std::cout << "  junit" << std::endl;
+      std::exit(0);
+    }
+    if (detail::cfg::use_reporter.starts_with("junit")) {
+      report_type_ = JUNIT;
+    } else {
+      report_type_ = CONSOLE;
+    }
+    if (!detail::cfg::use_colour.starts_with("yes")) {
+      color_ = {"", "", "", ""};
+    }
+    if (!detail::cfg::show_tests && !detail::cfg::show_test_names) {
+      std::cout.rdbuf(ss_out_.rdbuf());
+    }
+  }
+
+  auto on(events::suite_begin suite) -> void {
+    while (active_test_.size() > 0) {
+      pop_scope(active_test_.top());
+    }
+    active_suite_ = suite.name;
+    active_scope_ = &results_[active_suite_];
+  }
+
+  auto on(events::suite_end) -> void {
+    while (active_test_.size() > 0) {
+      pop_scope(active_test_.top());
+    }
+    active_suite_ = "global";
+    active_scope_ = &results_[active_suite_];
+  }
+
+  auto on(events::test_begin test_event) -> void {  // starts outermost test
+    check_for_scope(test_event.name);
+
+    if (report_type_ == CONSOLE) {
+      ss_out_ << "\n";
+      ss_out_ << std::string((2 * active_test_.size()) - 2, ' ');
+      ss_out_ << "Running " << test_event.type << " \"" << test_event.name
+              << "\"... ";
+    }
+  }
+
+  auto on(events::test_end test_event) -> void {
+    if (active_scope_->fails > 0) {
+      reset_printer();
+    } else {
+      active_scope_->report_string = ss_out_.str();
+      active_scope_->passed += 1LU;
+      if (report_type_ == CONSOLE) {
+        if (detail::cfg::show_successful_tests) {
+          if (!active_scope_->nested_tests->empty()) {
+            ss_out_ << "\n";
+            ss_out_ << std::string((2 * active_test_.size()) - 2, ' ');
+            ss_out_ << "Running test \"" << test_event.name << "\" - ";
+          }
+          ss_out_ << color_.pass << "PASSED" << color_.none;
+          print_duration(ss_out_);
+          lcout_ << ss_out_.str();
+          reset_printer();
+        }
+      }
+    }
+
+    pop_scope(test_event.name);
+  }
+
+  auto on(events::test_run test_event) -> void {  // starts nested test
+    on(events::test_begin{.type = test_event.type, .name = test_event.name});
+  }
+
+  auto on(events::test_finish test_event) -> void {  // finishes nested test
+    on(events::test_end{.type = test_event.type, .name = test_event.name});
+  }
+
+  auto on(events::test_skip test_event) -> void {
+    ss_out_.clear();
+    if (!active_scope_->nested_tests->contains(std::string(test_event.name))) {
+      check_for_scope(test_event.name);
+      active_scope_->status = "SKIPPED";
+      active_scope_->skipped += 1;
+      if (report_type_ == CONSOLE) {
+        lcout_ << '\n' << std::string((2 * active_test_.size()) - 2, ' ');
+        lcout_ << "Running \"" << test_event.name << "\"... ";
+        lcout_ << color_.skip << "SKIPPED" << color_.none << '\n';
+      }
+      reset_printer();
+      pop_scope(test_event.name);
+    }
+  }
+
+  template <class TMsg>
+  auto on(events::log<TMsg> log) -> void {
+    ss_out_ << log.msg;
+    if (report_type_ == CONSOLE) {
+      lcout_ << log.msg;
+    }
+  }
+
+  auto on(events::exception exception) -> void {
+    active_scope_->fails++;
+    if (!active_test_.empty()) {
+      active_scope_->report_string += color_.fail;
+      active_scope_->report_string += "Unexpected exception with message:\n";
+      active_scope_->report_string += exception.what();
+      active_scope_->report_string += color_.none;
+    }
+    if (report_type_ == CONSOLE) {
+      lcout_ << std::string((2 * active_test_.size()) - 2, ' ');
+      lcout_ << "Running test \"" << active_test_.top() << "\"... ";
+      lcout_ << color_.fail << "FAILED" << color_.none;
+      print_duration(lcout_);
+      lcout_ << '\n';
+      lcout_ << active_scope_->report_string << '\n';
+    }
+    if (detail::cfg::abort_early ||
+        active_scope_->fails >= detail::cfg::abort_after_n_failures) {
+      std::cerr << "early abort for test : " << active_test_.top() << "after ";
+      std::cerr << active_scope_->fails << " failures total." << std::endl;
+      std::exit(-1);
+    }
+  }
+
+  template <class TExpr>
+  BOOST_UT_ALWAYS_INLINE auto on(events::assertion_pass<TExpr>) -> void {
+    active_scope_->assertions++;
+  }
+
+  template <class TExpr>
+  auto on(events::assertion_fail<TExpr> assertion) -> void {
+    TPrinter ss{};
+    ss << ss_out_.str();
+    if (report_type_ == CONSOLE) {
+      ss << color_.fail << "FAILED\n" << color_.none;
+      print_duration(ss);
+    }
+    ss << "in: " << assertion.location.file_name() << ':'
+       << assertion.location.line();
+    ss << color_.fail << " - test condition: ";
+    ss << " [" << std::boolalpha << assertion.expr;
+    ss << color_.fail << ']' << color_.none;
+    active_scope_->report_string += ss.str();
+    active_scope_->fails++;
+    reset_printer();
+    if (report_type_ == CONSOLE) {
+      lcout_ << active_scope_->report_string << "\n\n";
+    }
+    if (detail::cfg::abort_early ||
+        active_scope_->fails >= detail::cfg::abort_after_n_failures) {
+      std::cerr << "early abort for test : " << active_test_.top() << "after ";
+      std::cerr << active_scope_->fails << " failures total." << std::endl;
+      std::exit(-1);
+    }
+  }
+
+  auto on(const events::fatal_assertion&) -> void { active_scope_->fails++; }
+
+  auto on(events::metric metric) -> void {
+    auto& metrics = active_scope_->metrics;
+    const auto it =
+        std::find_if(metrics.begin(), metrics.end(), [&](const auto& m) {
+          return m.kind == metric.kind and m.name == metric.name;
+        });
+    if (it == metrics.end()) {
+      metrics.push_back(
+          {std::string{metric.name}, metric.kind, metric.value});
+    } else if (metric.kind == "gauge") {
+      it->value = metric.value;
+    } else {
+      it->value += metric.value;
+    }
+  }
+
+  auto on(events::summary) -> void {
+    std::cout.flush();
+    std::cout.rdbuf(cout_save);
+    if (detail::cfg::show_tests or detail::cfg::show_test_names) {
+      return;
+    }
+    std::ofstream maybe_of;
+    if (detail::cfg::output_filename != "") {
+      maybe_of = std::ofstream(detail::cfg::output_filename);
+    }
+
+    if (report_type_ == JUNIT) {
+      print_junit_summary(detail::cfg::output_filename != "" ? maybe_of
+                                                             : std::cout);
+      return;
+    }
+    print_console_summary(
+        detail::cfg::output_filename != "" ? maybe_of : std::cout,
+        detail::cfg::output_filename != "" ? maybe_of : std::cerr);
+  }
+
+ protected:
+  void print_duration(auto& printer) const noexcept {
+    if (detail::cfg::show_duration) {
+      std::int64_t time_ms =
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              active_scope_->run_stop - active_scope_->run_start)
+              .count();
+      // rounded to nearest ms
+      double time_s = static_cast<double>(time_ms) / 1000.0;
+      printer << " after " << time_s << " seconds";
+    }
+  }
+
+  void print_console_summary(std::ostream& out_stream,
+                             std::ostream& err_stream) {
+    for (const auto& [suite_name, suite_result] : results_) {
+      if (suite_result.fails) {
+        err_stream
+            << "\n========================================================"
+               "=======================\n"
+            << "Suite " << suite_name << '\n'  //
+            << "tests:   " << (suite_result.n_tests) << " | " << color_.fail
+            << suite_result.fails << " failed" << color_.none << '\n'
+            << "asserts: " << (suite_result.assertions) << " | "
+            << suite_result.passed << " passed"
+            << " | " << color_.fail << suite_result.fails << " failed"
+            << color_.none << '\n';
+        std::cerr << std::endl;
+      } else {
+        out_stream << color_.pass << "Suite '" << suite_name
+                   << "': all tests passed" << color_.none << " ("
+                   << suite_result.assertions << " asserts in "
+                   << suite_result.n_tests << " tests)\n";
+
+        if (suite_result.skipped) {
+          std::cout << suite_result.skipped << " tests skipped\n";
+        }
+
+        std::cout.flush();
+      }
+      print_metrics(out_stream, "", suite_result);
+    }
+  }
+
+  void print_metrics(std::ostream& stream, const std::string& prefix,
+                     const test_result& parent) {
+    for (const auto& [name, result] : *parent.nested_tests) {
+      const auto path = prefix.empty() ? name : prefix + '.' + name;
+      if (!result.metrics.empty()) {
+        stream << "  \"" << path << "\":";
+        for (const auto& metric : result.metrics) {
+          stream << ' ' << metric.name << '='
+                 << detail::metrics::format(metric.value);
+        }
+        stream << '\n';
+      }
+      print_metrics(stream, path, result);
+    }
+  }
+
+  void print_junit_summary(std::ostream& stream) {
+    // aggregate results
+    size_t n_tests = 0;
+    size_t n_fails = 0;
+    double total_time = 0.0;
+    auto suite_time = [](auto const& suite_result) {
+      std::int64_t time_ms =
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              suite_result.run_stop - suite_result.run_start)
+              .count();
+      return static_cast<double>(time_ms) / 1000.0;
+    };
+    for (const auto& [suite_name, suite_result] : results_) {
+      n_tests += suite_result.assertions;
+      n_fails += suite_result.fails;
+      total_time += suite_time(suite_result);
+    }
+
+    // mock junit output:
+    stream << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    stream << "<testsuites";
+    stream << " name=\"all\"";
+    stream << " tests=\"" << n_tests << '\"';
+    stream << " failures=\"" << n_fails << '\"';
+    stream << " time=\"" << total_time << '\"';
+    stream << ">\n";
+
+    for (const auto& [suite_name, suite_result] : results_) {
+      stream << "<testsuite";
+      stream << " classname=\"" << detail::cfg::executable_name << '\"';
+      stream << " name=\"" << suite_name << '\"';
+      stream << " tests=\"" << suite_result.assertions << '\"';
+      stream << " errors=\"" << suite_result.fails << '\"';
+      stream << " failures=\"" << suite_result.fails << '\"';
+      stream << " skipped=\"" << suite_result.skipped << '\"';
+      stream << " time=\"" << suite_time(suite_result) << '\"';
+      stream << " version=\"" << BOOST_UT_VERSION << "\">\n";
+      print_result(stream, suite_name, " ", suite_result);
+      stream << "</testsuite>\n";
+      stream.flush();
+    }
+    stream << "</testsuites>";
+  }
+  void print_result(std::ostream& stream, const std::string& suite_name,
+                    const std::string& indent, const test_result& parent) {
+    for (const auto& [name, result] : *parent.nested_tests) {
+      stream << indent;
+      stream << "<testcase classname=\"" << escape(result.suite_name) << '\"';
+      stream << " name=\"" << escape(name) << '\"';
+      stream << " tests=\"" << result.assertions << '\"';
+      stream << " errors=\"" << result.fails << '\"';
+      stream << " failures=\"" << result.fails << '\"';
+      stream << " skipped=\"" << result.skipped << '\"';
+      std::int64_t time_ms =
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              result.run_stop - result.run_start)
+              .count();
+      stream << " time=\"" << (static_cast<double>(time_ms) / 1000.0) << "\"";
+      stream << " status=\"" << result.status << '\"';
+      if (result.report_string.empty() && result.nested_tests->empty() &&
+          result.metrics.empty()) {
+        stream << " />\n";
+      } else if (!result.nested_tests->empty()) {
+        stream << ">\n";
+        print_properties(stream, indent + indent, result);
+        print_result(stream, suite_name, indent + "  ", result);
+        stream << indent << "</testcase>\n";
+      } else {
+        stream << ">\n";
+        print_properties(stream, indent + indent, result);
+        if (!result.report_string.empty()) {
+          stream << indent << indent << "<system-out>\n";
+          stream << result.report_string << "\n";
+          stream << indent << indent << "</system-out>\n";
+        }
+        stream << indent << "</testcase>\n";
       }
-      active_scope_->n_tests += old_scope->n_tests + 1LU;
-      active_scope_->assertions += old_scope->assertions;
-      active_scope_->passed += old_scope->passed;
-      active_scope_->skipped += old_scope->skipped;
-      active_scope_->fails += old_scope->fails;
+    }
+  }
+
+  /// `text` as XML attribute value
+  [[nodiscard]] static auto escape(const std::string_view text) -> std::string {
+    auto escaped = std::string{};
+    for (const auto c : text) {
+      switch (c) {
+        case '&':
+          escaped += "&amp;";
+          break;
+        case '<':
+          escaped += "&lt;";
+          break;
+        case '>':
+          escaped += "&gt;";
+          break;
+        case '"':
+          escaped += "&quot;";
+          break;
+        case '\'':
+          escaped += "&apos;";
+          break;
+        default:
+          escaped += c;
+      }
+    }
+    return escaped;
+  }
+
+  void print_properties(std::ostream& stream, const std::string& indent,
+                        const test_result& result) {
+    if (result.metrics.empty()) {
       return;
     }
-    std::stringstream ss("runner returned from test w/o signaling: ");
-    ss << "not popping because '" << active_test_.top() << "' differs from '"
-       << test_name << "'" << std::endl;
-#if defined(__cpp_exceptions)
-    throw std::logic_error(ss.str());
-#else
-    std::abort();
-#endif
+    stream << indent << "<properties>\n";
+    for (const auto& metric : result.metrics) {
+      stream << indent << "  <property name=\"" << escape(metric.name)
+             << "\" value=\"" << escape(detail::metrics::format(metric.value))
+             << "\" />\n";
+    }
+    stream << indent << "</properties>\n";
   }
+};
+
+namespace detail {
+template <class TEvent, class TSubscription>
+inline constexpr auto is_event = std::is_same_v<TEvent, TSubscription>;
+
+template <template <class...> class TEvent, class... Ts, class... TArgs>
+inline constexpr auto is_event<TEvent<Ts...>, TEvent<TArgs...>> = true;
+
+/// Whether `TReporter` wants to receive `TEvent`. Reporters opt in by listing
+/// the events they consume, templated events match any instantiation:
+/// @example using subscribed_events =
+///   type_traits::list<events::assertion_fail<>, events::summary>;
+/// Reporters without a subscription receive every event.
+template <class TReporter, class TEvent>
+inline constexpr auto is_subscribed = [] {
+  if constexpr (requires { TReporter::template subscribes<TEvent>; }) {
+    return bool(TReporter::template subscribes<TEvent>);
+  } else if constexpr (requires { typename TReporter::subscribed_events; }) {
+    return []<class... Ts>(type_traits::list<Ts...>) {
+      return (is_event<TEvent, Ts> or ...);
+    }(typename TReporter::subscribed_events{});
+  } else {
+    return true;
+  }
+}();
+}  // namespace detail
+
+/// Forwards every event to each of `TReporters` (in declaration order) so that
+/// a single run can produce several reports, e.g. console output and JUnit.
+/// Dispatch is resolved at compile-time; reporters which don't handle an event
+/// are skipped. The summary is delivered in reverse order so that reporters
+/// redirecting std::cout restore it before earlier ones print.
+/// @example runner<reporters<reporter<printer>, reporter_junit<printer>>>{}
+template <class... TReporters>
+class reporters {
+  template <class TReporter, class TEvent>
+  static constexpr auto handled_by =
+      requires(TReporter& reporter, const TEvent& event) { reporter.on(event); };
+
+  template <class TEvent>
+  static constexpr auto handles = (handled_by<TReporters, TEvent> or ...);
 
  public:
-  constexpr auto operator=(TPrinter printer) {
-    printer_ = static_cast<TPrinter&&>(printer);
+  template <class TEvent>
+  static constexpr auto subscribes =
+      (detail::is_subscribed<TReporters, TEvent> or ...);
+
+  constexpr auto operator=(const colors& colors) {
+    std::apply([&](auto&... reporter) { (assign(reporter, colors), ...); },
+               reporters_);
   }
-  reporter_junit() : lcout_(std::cout.rdbuf()) {}
-  ~reporter_junit() { std::cout.rdbuf(cout_save); }
 
-  auto on(events::run_begin run) {
-    ::boost::ut::detail::cfg::parse_arg_with_fallback(run.argc, run.argv);
+  template <class TEvent>
+    requires handles<TEvent>
+  auto on(const TEvent& event) -> void {
+    std::apply([&](auto&... reporter) { (dispatch(reporter, event), ...); },
+               reporters_);
+  }
 
-    if (detail::cfg::show_reporters) {
-      std::cout << "available reporter:\n";
-      std::cout << "  console (default)\n";
-      std::cout << "  junit" << std::endl;
-      std::exit(0);
+  auto on(const events::summary& event) -> void
+    requires handles<events::summary>
+  {
+    constexpr auto size = sizeof...(TReporters);
+    [&]<std::size_t... Ns>(std::index_sequence<Ns...>) {
+      (dispatch(std::get<size - 1 - Ns>(reporters_), event), ...);
+    }(std::make_index_sequence<size>{});
+  }
+
+  template <class TReporter>
+  [[nodiscard]] constexpr auto get() -> TReporter& {
+    return std::get<TReporter>(reporters_);
+  }
+
+ private:
+  template <class TReporter>
+  static constexpr auto assign(TReporter& reporter, const colors& colors)
+      -> void {
+    if constexpr (requires { reporter = {colors}; }) {
+      reporter = {colors};
     }
-    if (detail::cfg::use_reporter.starts_with("junit")) {
-      report_type_ = JUNIT;
-    } else {
-      report_type_ = CONSOLE;
+  }
+
+  template <class TReporter, class TEvent>
+  static constexpr auto dispatch(TReporter& reporter, const TEvent& event)
+      -> void {
+    if constexpr (handled_by<TReporter, TEvent> and
+                  detail::is_subscribed<TReporter, TEvent>) {
+      reporter.on(event);
     }
-    if (!detail::cfg::use_colour.starts_with("yes")) {
-      color_ = {"", "", "", ""};
+  }
+
+  std::tuple<TReporters...> reporters_{};
+};
+
+/// Manually driven std::chrono clock for time dependent code under test.
+/// Sleeping on it never blocks for real: once every participant is asleep
+/// the clock jumps straight to the earliest pending deadline.
+class virtual_clock {
+ public:
+  using rep = std::chrono::nanoseconds::rep;
+  using period = std::chrono::nanoseconds::period;
+  using duration = std::chrono::nanoseconds;
+  using time_point = std::chrono::time_point<virtual_clock>;
+  static constexpr bool is_steady = true;
+
+  /// thread taking part in virtual time, time is only advanced automatically
+  /// when all participants sleep on the clock (or, without any, the thread
+  /// which sleeps). Joins on destruction.
+  class thread {
+   public:
+    template <class TFn>
+    explicit thread(TFn fn)
+        : thread_{[fn = std::move(fn), registered = participant{}]() mutable {
+            const auto bound = participant{std::move(registered), true};
+            fn();
+          }} {}
+    thread(thread&&) noexcept = default;
+    thread& operator=(thread&&) noexcept = default;
+    ~thread() {
+      if (thread_.joinable()) {
+        thread_.join();
+      }
     }
-    if (!detail::cfg::show_tests && !detail::cfg::show_test_names) {
-      std::cout.rdbuf(ss_out_.rdbuf());
+
+    auto join() -> void { thread_.join(); }
+    [[nodiscard]] auto joinable() const noexcept -> bool {
+      return thread_.joinable();
     }
+
+   private:
+    std::thread thread_;
+  };
+
+  [[nodiscard]] static auto now() noexcept -> time_point {
+    return time_point{duration{now_.load(std::memory_order_acquire)}};
   }
 
-  auto on(events::suite_begin suite) -> void {
-    while (active_test_.size() > 0) {
-      pop_scope(active_test_.top());
+  static auto advance(const duration d) -> void {
+    std::unique_lock lock{mutex_};
+    advance_to(lock, now() + d);
+  }
+
+  template <class TRep, class TPeriod>
+  static auto sleep_for(const std::chrono::duration<TRep, TPeriod>& d)
+      -> void {
+    sleep_until(now() + std::chrono::ceil<duration>(d));
+  }
+
+  static auto sleep_until(const time_point tp) -> void {
+    std::unique_lock lock{mutex_};
+    const std::size_t counted = participating_;
+    sleepers_ += counted;
+    deadlines_.push_back(tp);
+    while (now() < tp) {
+      if (participants_ == 0 or sleepers_ >= participants_) {
+        advance_to(lock, next_deadline(tp));
+      } else {
+        wakeup_.wait(lock);
+      }
     }
-    active_suite_ = suite.name;
-    active_scope_ = &results_[active_suite_];
+    deadlines_.erase(std::find(deadlines_.begin(), deadlines_.end(), tp));
+    sleepers_ -= counted;
+  }
+
+  /// invokes timer, on the thread advancing the clock, once now() + d is
+  /// reached
+  template <class TRep, class TPeriod>
+  static auto call_after(const std::chrono::duration<TRep, TPeriod>& d,
+                         std::function<void()> timer) -> void {
+    const std::scoped_lock lock{mutex_};
+    timers_.emplace_back(now() + std::chrono::ceil<duration>(d),
+                         std::move(timer));
+  }
+
+  /// rewinds to the epoch and drops pending timers, returns false (and
+  /// changes nothing) while any thread still sleeps on the clock
+  [[nodiscard]] static auto reset() -> bool {
+    const std::scoped_lock lock{mutex_};
+    if (not deadlines_.empty()) {
+      return false;
+    }
+    now_.store(0, std::memory_order_release);
+    timers_.clear();
+    return true;
   }
 
-  auto on(events::suite_end) -> void {
-    while (active_test_.size() > 0) {
-      pop_scope(active_test_.top());
+ private:
+  class participant {
+   public:
+    participant() {
+      const std::scoped_lock lock{mutex_};
+      ++participants_;
     }
-    active_suite_ = "global";
-    active_scope_ = &results_[active_suite_];
+    participant(participant&& other, const bool bound = false) noexcept
+        : active_{std::exchange(other.active_, false)}, bound_{bound} {
+      participating_ = participating_ or bound;
+    }
+    participant(const participant&) = delete;
+    participant& operator=(const participant&) = delete;
+    participant& operator=(participant&&) = delete;
+    ~participant() {
+      if (bound_) {
+        participating_ = false;
+      }
+      if (active_) {
+        const std::scoped_lock lock{mutex_};
+        --participants_;
+        wakeup_.notify_all();
+      }
+    }
+
+   private:
+    bool active_{true};
+    bool bound_{};
+  };
+
+  /// earliest deadline still ahead, up to tp; deadlines already reached
+  /// belong to woken threads which haven't left sleep_until yet
+  [[nodiscard]] static auto next_deadline(time_point tp) -> time_point {
+    for (const auto deadline : deadlines_) {
+      if (deadline > now()) {
+        tp = std::min(tp, deadline);
+      }
+    }
+    for (const auto& [deadline, _] : timers_) {
+      tp = std::min(tp, deadline);
+    }
+    return tp;
   }
 
-  auto on(events::test_begin test_event) -> void {  // starts outermost test
-    check_for_scope(test_event.name);
+  static auto advance_to(std::unique_lock<std::mutex>& lock,
+                         const time_point tp) -> void {
+    for (;;) {
+      const auto timer = std::min_element(
+          timers_.begin(), timers_.end(),
+          [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+      if (timer == timers_.end() or timer->first > tp) {
+        break;
+      }
+      set(std::max(now(), timer->first));
+      auto fire = std::move(timer->second);
+      timers_.erase(timer);
+      lock.unlock();
+      fire();
+      lock.lock();
+    }
+    set(std::max(now(), tp));
+    wakeup_.notify_all();
+  }
 
-    if (report_type_ == CONSOLE) {
-      ss_out_ << "\n";
-      ss_out_ << std::string((2 * active_test_.size()) - 2, ' ');
-      ss_out_ << "Running " << test_event.type << " \"" << test_event.name
-              << "\"... ";
+  static auto set(const time_point tp) -> void {
+    now_.store(tp.time_since_epoch().count(), std::memory_order_release);
+  }
+
+  static inline std::mutex mutex_{};
+  static inline std::condition_variable wakeup_{};
+  static inline std::atomic<rep> now_{};
+  static inline std::size_t participants_{};
+  static inline std::size_t sleepers_{};
+  static inline thread_local bool participating_{};
+  static inline std::vector<time_point> deadlines_{};
+  static inline std::vector<std::pair<time_point, std::function<void()>>>
+      timers_{};
+};
+
+struct options {
+  std::string_view filter{};
+  std::vector<std::string_view> tag{};
+  ut::colors colors{};
+  bool dry_run{};
+};
+
+struct run_cfg {
+  bool report_errors{false};
+  int argc{0};
+  const char** argv{nullptr};
+};
+
+template <class TReporter = reporter<printer>, auto MaxPathSize = 16>
+class runner {
+  class filter {
+    static constexpr auto delim = ".";
+
+   public:
+    constexpr /*explicit(false)*/ filter(std::string_view _filter = {})
+        : path_{utility::split(_filter, delim)} {}
+
+    template <class TPath>
+    constexpr auto operator()(const std::size_t level, const TPath& path) const
+        -> bool {
+      for (auto i = 0u; i < math::min_value(level + 1, std::size(path_)); ++i) {
+        if (not utility::is_match(path[i], path_[i])) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+   private:
+    std::vector<std::string_view> path_{};
+  };
+
+ public:
+  constexpr runner() = default;
+  constexpr runner(TReporter reporter, std::size_t suites_size)
+      : reporter_{std::move(reporter)}, suites_(suites_size) {}
+
+  ~runner() {
+    const auto should_run = not run_;
+
+    if (should_run) {
+      static_cast<void>(run());
+    }
+
+    if (not dry_run_) {
+      report_summary();
+    }
+#if defined(BOOST_UT_RUN_TOOLS)
+    profiler_.stop();
+#endif
+    if (not detail::cfg::trace_markers.empty()) {
+      detail::trace::close();
+    }
+
+#if defined(BOOST_UT_HAS_POSIX_RUN_TOOLS)
+    detail::interrupts::release(this);
+#endif
+
+    if (should_run and fails_) {
+      std::exit(-1);
     }
   }
 
-  auto on(events::test_end test_event) -> void {
-    if (active_scope_->fails > 0) {
-      reset_printer();
-    } else {
-      active_scope_->report_string = ss_out_.str();
-      active_scope_->passed += 1LU;
-      if (report_type_ == CONSOLE) {
-        if (detail::cfg::show_successful_tests) {
-          if (!active_scope_->nested_tests->empty()) {
-            ss_out_ << "\n";
-            ss_out_ << std::string((2 * active_test_.size()) - 2, ' ');
-            ss_out_ << "Running test \"" << test_event.name << "\" - ";
-          }
-          ss_out_ << color_.pass << "PASSED" << color_.none;
-          print_duration(ss_out_);
-          lcout_ << ss_out_.str();
-          reset_printer();
+  auto operator=(const options& options) {
+    filter_ = options.filter;
+    tag_ = options.tag;
+    dry_run_ = options.dry_run;
+    diverted_ = dry_run_;
+    reporter_ = {options.colors};
+  }
+
+  template <class TSuite>
+  auto on(events::suite<TSuite> suite) {
+    suites_.emplace_back(suite.run, suite.name);
+  }
+
+  template <class... Ts>
+  auto on(events::test<Ts...> test) -> void {
+#if defined(__cpp_exceptions)
+    if (recording_) {
+      if (recording_->load) {
+        return serialized([&] { on(std::move(test)); });
+      }
+      return record(erased(test, [&test] { test(); }));
+    }
+#endif
+    path_[level_] = test.name;
+    if (not level_) {
+      ++declared_;
+    }
+
+#if defined(BOOST_UT_HAS_POSIX_RUN_TOOLS)
+    if (bisect_.active and not level_ and not bisect_select(test.name)) {
+      return;
+    }
+#endif
+#if defined(BOOST_UT_RUN_TOOLS)
+    if (replaying_ and not level_) {
+      if (const auto replayed = replayed_.find(declared_ - 1);
+          replayed == replayed_.cend() or replayed->second != test.name) {
+        return;
+      }
+    }
+#endif
+
+    if (detail::cfg::list_tags) {
+      std::for_each(test.tag.cbegin(), test.tag.cend(), [](const auto& tag) {
+        std::cout << "tag: " << tag << std::endl;
+      });
+      return;
+    }
+
+    auto execute = std::empty(test.tag);
+    for (const auto& tag_element : test.tag) {
+      if (utility::is_match(tag_element, "skip") && !detail::cfg::show_tests &&
+          !detail::cfg::show_test_names) {
+        on(events::skip<>{.type = test.type, .name = test.name});
+        return;
+      }
+
+      for (const auto& ftag : tag_) {
+        if (utility::is_match(tag_element, ftag)) {
+          execute = true;
+          break;
         }
       }
     }
 
-    pop_scope(test_event.name);
-  }
-
-  auto on(events::test_run test_event) -> void {  // starts nested test
-    on(events::test_begin{.type = test_event.type, .name = test_event.name});
-  }
-
-  auto on(events::test_finish test_event) -> void {  // finishes nested test
-    on(events::test_end{.type = test_event.type, .name = test_event.name});
-  }
-
-  auto on(events::test_skip test_event) -> void {
-    ss_out_.clear();
-    if (!active_scope_->nested_tests->contains(std::string(test_event.name))) {
-      check_for_scope(test_event.name);
-      active_scope_->status = "SKIPPED";
-      active_scope_->skipped += 1;
-      if (report_type_ == CONSOLE) {
-        lcout_ << '\n' << std::string((2 * active_test_.size()) - 2, ' ');
-        lcout_ << "Running \"" << test_event.name << "\"... ";
-        lcout_ << color_.skip << "SKIPPED" << color_.none << '\n';
+    if (!detail::cfg::query_pattern.empty()) {
+      const static auto regex = detail::cfg::query_regex_pattern;
+      bool matches = utility::regex_match(test.name.data(), regex.c_str());
+      for (const auto& tag2 : test.tag) {
+        matches |= utility::regex_match(tag2.data(), regex.c_str());
+      }
+      if (matches) {
+        execute = !detail::cfg::invert_query_pattern;
+      } else {
+        execute = detail::cfg::invert_query_pattern;
       }
-      reset_printer();
-      pop_scope(test_event.name);
     }
-  }
 
-  template <class TMsg>
-  auto on(events::log<TMsg> log) -> void {
-    ss_out_ << log.msg;
-    if (report_type_ == CONSOLE) {
-      lcout_ << log.msg;
+    if (detail::cfg::show_tests || detail::cfg::show_test_names) {
+      if (not detail::cfg::output_filename.empty() and not list_.is_open()) {
+        list_.open(detail::cfg::output_filename);
+      }
+      auto& out = list_.is_open() ? list_ : std::cout;
+      if (!detail::cfg::show_test_names) {
+        out << "matching test: ";
+      }
+      out << test.name << std::endl;
+      return;
     }
-  }
 
-  auto on(events::exception exception) -> void {
-    active_scope_->fails++;
-    if (!active_test_.empty()) {
-      active_scope_->report_string += color_.fail;
-      active_scope_->report_string += "Unexpected exception with message:\n";
-      active_scope_->report_string += exception.what();
-      active_scope_->report_string += color_.none;
-    }
-    if (report_type_ == CONSOLE) {
-      lcout_ << std::string((2 * active_test_.size()) - 2, ' ');
-      lcout_ << "Running test \"" << active_test_.top() << "\"... ";
-      lcout_ << color_.fail << "FAILED" << color_.none;
-      print_duration(lcout_);
-      lcout_ << '\n';
-      lcout_ << active_scope_->report_string << '\n';
+    if (not execute) {
+      on(events::skip<>{.type = test.type, .name = test.name});
+      return;
     }
-    if (detail::cfg::abort_early ||
-        active_scope_->fails >= detail::cfg::abort_after_n_failures) {
-      std::cerr << "early abort for test : " << active_test_.top() << "after ";
-      std::cerr << active_scope_->fails << " failures total." << std::endl;
-      std::exit(-1);
+
+    if (filter_(level_, path_) and
+        std::all_of(selected_.cbegin(), selected_.cend(),
+                    [this](const auto& paths) {
+                      return paths.matches(level_, path_);
+                    })) {
+#if defined(__cpp_exceptions)
+      if (not parallel_.empty() and parallel_.back().level == level_) {
+        auto deferred = std::make_shared<events::test<Ts...>>(std::move(test));
+        return defer(erased(*deferred, [deferred] { (*deferred)(); }));
+      }
+#endif
+#if defined(BOOST_UT_RUN_TOOLS)
+      if (budget_ and not level_ and not dry_run_ and
+          not budget_.admit(test.name, test.location.file_name())) {
+        on(events::skip<>{.type = test.type, .name = test.name});
+        return;
+      }
+#endif
+      run_test({.type = test.type,
+                .name = test.name,
+                .max_stack = test.max_stack,
+                .location = test.location,
+                .body =
+                    [](void* t) {
+                      (*static_cast<events::test<Ts...>*>(t))();
+                    },
+                .test = &test});
+#if defined(BOOST_UT_RUN_TOOLS)
+      if (budget_ and not level_) {
+        budget_.finished();
+      }
+#endif
     }
   }
 
-  template <class TExpr>
-  auto on(events::assertion_pass<TExpr>) -> void {
-    active_scope_->assertions++;
+  template <class... Ts>
+  auto on(events::skip<Ts...> test) {
+    report(events::test_skip{.type = test.type, .name = test.name});
   }
 
   template <class TExpr>
-  auto on(events::assertion_fail<TExpr> assertion) -> void {
-    TPrinter ss{};
-    ss << ss_out_.str();
-    if (report_type_ == CONSOLE) {
-      ss << color_.fail << "FAILED\n" << color_.none;
-      print_duration(ss);
-    }
-    ss << "in: " << assertion.location.file_name() << ':'
-       << assertion.location.line();
-    ss << color_.fail << " - test condition: ";
-    ss << " [" << std::boolalpha << assertion.expr;
-    ss << color_.fail << ']' << color_.none;
-    active_scope_->report_string += ss.str();
-    active_scope_->fails++;
-    reset_printer();
-    if (report_type_ == CONSOLE) {
-      lcout_ << active_scope_->report_string << "\n\n";
+  [[nodiscard]] BOOST_UT_ALWAYS_INLINE auto on(
+      const events::assertion<TExpr>& assertion) -> bool {
+    if (diverted_) {
+      if (dry_run_) {
+        return true;
+      }
+#if defined(__cpp_exceptions)
+      if (recording_ and static_cast<bool>(assertion.expr)) {
+        ++recording_->passes;  // no call, which would slow down the loop
+        return true;
+      }
+#endif
     }
-    if (detail::cfg::abort_early ||
-        active_scope_->fails >= detail::cfg::abort_after_n_failures) {
-      std::cerr << "early abort for test : " << active_test_.top() << "after ";
-      std::cerr << active_scope_->fails << " failures total." << std::endl;
-      std::exit(-1);
+
+    if (static_cast<bool>(assertion.expr)) {
+      if constexpr (subscribed<events::assertion_pass<TExpr>>) {
+        report(events::assertion_pass<TExpr>{.expr = assertion.expr,
+                                             .location = assertion.location});
+      }
+      return true;
     }
+    return fail_assertion(assertion);
   }
 
-  auto on(const events::fatal_assertion&) -> void { active_scope_->fails++; }
-
-  auto on(events::summary) -> void {
-    std::cout.flush();
-    std::cout.rdbuf(cout_save);
-    std::ofstream maybe_of;
-    if (detail::cfg::output_filename != "") {
-      maybe_of = std::ofstream(detail::cfg::output_filename);
+  auto on(events::fatal_assertion fatal_assertion) -> void {
+#if defined(__cpp_exceptions)
+    if (recording_) {
+      if (recording_->load) {
+        return serialized([&] { on(fatal_assertion); });
+      }
+      recording_->calls.emplace_back(
+          [this, fatal_assertion] { on(fatal_assertion); });
+      throw fatal_assertion;
     }
+#endif
+    report(fatal_assertion);
 
-    if (report_type_ == JUNIT) {
-      print_junit_summary(detail::cfg::output_filename != "" ? maybe_of
-                                                             : std::cout);
-      return;
+#if defined(__cpp_exceptions)
+    if (not level_) {
+      report_summary();
     }
-    print_console_summary(
-        detail::cfg::output_filename != "" ? maybe_of : std::cout,
-        detail::cfg::output_filename != "" ? maybe_of : std::cerr);
-  }
-
- protected:
-  void print_duration(auto& printer) const noexcept {
-    if (detail::cfg::show_duration) {
-      std::int64_t time_ms =
-          std::chrono::duration_cast<std::chrono::milliseconds>(
-              active_scope_->run_stop - active_scope_->run_start)
-              .count();
-      // rounded to nearest ms
-      double time_s = static_cast<double>(time_ms) / 1000.0;
-      printer << " after " << time_s << " seconds";
+    throw fatal_assertion;
+#else
+    if (level_) {
+      report(events::test_end{});
     }
+    report_summary();
+    std::abort();
+#endif
   }
 
-  void print_console_summary(std::ostream& out_stream,
-                             std::ostream& err_stream) {
-    for (const auto& [suite_name, suite_result] : results_) {
-      if (suite_result.fails) {
-        err_stream
-            << "\n========================================================"
-               "=======================\n"
-            << "Suite " << suite_name << '\n'  //
-            << "tests:   " << (suite_result.n_tests) << " | " << color_.fail
-            << suite_result.fails << " failed" << color_.none << '\n'
-            << "asserts: " << (suite_result.assertions) << " | "
-            << suite_result.passed << " passed"
-            << " | " << color_.fail << suite_result.fails << " failed"
-            << color_.none << '\n';
-        std::cerr << std::endl;
+  template <class TMsg>
+  auto on(events::log<TMsg> l) -> void {
+#if defined(__cpp_exceptions)
+    if (recording_) {
+      if (recording_->load) {
+        return serialized([&] { on(l); });
+      }
+      if constexpr (std::is_convertible_v<TMsg, std::string_view>) {
+        recording_->calls.emplace_back(
+            [this, msg = std::string{std::string_view{l.msg}}] {
+              on(events::log<std::string>{.msg = msg});
+            });
       } else {
-        out_stream << color_.pass << "Suite '" << suite_name
-                   << "': all tests passed" << color_.none << " ("
-                   << suite_result.assertions << " asserts in "
-                   << suite_result.n_tests << " tests)\n";
-
-        if (suite_result.skipped) {
-          std::cout << suite_result.skipped << " tests skipped\n";
-        }
-
-        std::cout.flush();
+        recording_->calls.emplace_back([this, l] { on(l); });
       }
+      return;
     }
+#endif
+    report(l);
   }
 
-  void print_junit_summary(std::ostream& stream) {
-    // aggregate results
-    size_t n_tests = 0;
-    size_t n_fails = 0;
-    double total_time = 0.0;
-    auto suite_time = [](auto const& suite_result) {
-      std::int64_t time_ms =
-          std::chrono::duration_cast<std::chrono::milliseconds>(
-              suite_result.run_stop - suite_result.run_start)
-              .count();
-      return static_cast<double>(time_ms) / 1000.0;
-    };
-    for (const auto& [suite_name, suite_result] : results_) {
-      n_tests += suite_result.assertions;
-      n_fails += suite_result.fails;
-      total_time += suite_time(suite_result);
+  auto on(events::load_begin) -> void {
+#if defined(__cpp_exceptions)
+    if (not load_.depth++) {
+      load_.parent = std::exchange(
+          recording_, &load_.calls.emplace_back(recording{.load = true}));
+      if (not load_.parent) {
+        diverted_ = true;
+      }
     }
+#endif
+  }
 
-    // mock junit output:
-    stream << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
-    stream << "<testsuites";
-    stream << " name=\"all\"";
-    stream << " tests=\"" << n_tests << '\"';
-    stream << " failures=\"" << n_fails << '\"';
-    stream << " time=\"" << total_time << '\"';
-    stream << ">\n";
-
-    for (const auto& [suite_name, suite_result] : results_) {
-      stream << "<testsuite";
-      stream << " classname=\"" << detail::cfg::executable_name << '\"';
-      stream << " name=\"" << suite_name << '\"';
-      stream << " tests=\"" << suite_result.assertions << '\"';
-      stream << " errors=\"" << suite_result.fails << '\"';
-      stream << " failures=\"" << suite_result.fails << '\"';
-      stream << " skipped=\"" << suite_result.skipped << '\"';
-      stream << " time=\"" << suite_time(suite_result) << '\"';
-      stream << " version=\"" << BOOST_UT_VERSION << "\">\n";
-      print_result(stream, suite_name, " ", suite_result);
-      stream << "</testsuite>\n";
-      stream.flush();
-    }
-    stream << "</testsuites>";
+  auto on(events::load_worker) -> void {
+#if defined(__cpp_exceptions)
+    const std::scoped_lock lock{load_.mutex};
+    recording_ = &load_.calls.emplace_back(recording{.load = true});
+#endif
   }
-  void print_result(std::ostream& stream, const std::string& suite_name,
-                    const std::string& indent, const test_result& parent) {
-    for (const auto& [name, result] : *parent.nested_tests) {
-      stream << indent;
-      stream << "<testcase classname=\"" << result.suite_name << '\"';
-      stream << " name=\"" << name << '\"';
-      stream << " tests=\"" << result.assertions << '\"';
-      stream << " errors=\"" << result.fails << '\"';
-      stream << " failures=\"" << result.fails << '\"';
-      stream << " skipped=\"" << result.skipped << '\"';
-      std::int64_t time_ms =
-          std::chrono::duration_cast<std::chrono::milliseconds>(
-              result.run_stop - result.run_start)
-              .count();
-      stream << " time=\"" << (static_cast<double>(time_ms) / 1000.0) << "\"";
-      stream << " status=\"" << result.status << '\"';
-      if (result.report_string.empty() && result.nested_tests->empty()) {
-        stream << " />\n";
-      } else if (!result.nested_tests->empty()) {
-        stream << " />\n";
-        print_result(stream, suite_name, indent + "  ", result);
-        stream << indent << "</testcase>\n";
-      } else if (!result.report_string.empty()) {
-        stream << ">\n";
-        stream << indent << indent << "<system-out>\n";
-        stream << result.report_string << "\n";
-        stream << indent << indent << "</system-out>\n";
-        stream << indent << "</testcase>\n";
+
+  auto on(events::load_end) -> void {
+#if defined(__cpp_exceptions)
+    if (not --load_.depth) {
+      recording_ = load_.parent;
+      auto passes = std::size_t{};
+      for (const auto& calls : load_.calls) {
+        passes += calls.passes;
+      }
+      load_.calls.clear();
+      if (recording_) {
+        recording_->passes += passes;
+      } else {
+        diverted_ = dry_run_;
+        report_passes(passes);
       }
     }
+#endif
   }
-};
-
-struct options {
-  std::string_view filter{};
-  std::vector<std::string_view> tag{};
-  ut::colors colors{};
-  bool dry_run{};
-};
-
-struct run_cfg {
-  bool report_errors{false};
-  int argc{0};
-  const char** argv{nullptr};
-};
 
-template <class TReporter = reporter<printer>, auto MaxPathSize = 16>
-class runner {
-  class filter {
-    static constexpr auto delim = ".";
+  auto on(events::parallel_begin) -> void {
+#if defined(__cpp_exceptions)
+    if (not recording_ and level_) {
+      parallel_.push_back({.level = level_});
+    }
+#endif
+  }
 
-   public:
-    constexpr /*explicit(false)*/ filter(std::string_view _filter = {})
-        : path_{utility::split(_filter, delim)} {}
+  auto on(events::parallel_end) -> void {
+#if defined(__cpp_exceptions)
+    if (recording_ or parallel_.empty() or parallel_.back().level != level_) {
+      return;
+    }
+    auto children = std::move(parallel_.back().children);
+    parallel_.pop_back();
+    auto next = std::atomic<std::size_t>{};
+    const auto work = [&] {
+      for (auto i = next++; i < children.size(); i = next++) {
+        children[i].run();
+      }
+    };
+    diverted_ = true;
+    auto workers = std::vector<std::thread>{};
+    for (auto n = std::min<std::size_t>(std::thread::hardware_concurrency(),
+                                        children.size());
+         n > 1; --n) {
+      workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    diverted_ = dry_run_;
+    for (const auto& forked : children) {
+      forked.report();
+    }
+#endif
+  }
 
-    template <class TPath>
-    constexpr auto operator()(const std::size_t level, const TPath& path) const
-        -> bool {
-      for (auto i = 0u; i < math::min_value(level + 1, std::size(path_)); ++i) {
-        if (not utility::is_match(path[i], path_[i])) {
-          return false;
+  [[nodiscard]] auto run(run_cfg rc = {}) -> bool {
+    run_ = true;
+    report(events::run_begin{.argc = rc.argc, .argv = rc.argv});
+    if (state_.load(detail::cfg::run_state_file()) and
+        detail::cfg::last_failed) {
+      if (state_.build_id() != detail::run_state::current_build_id()) {
+        std::cerr << "--last-failed: rerunning the failures of an earlier "
+                     "build"
+                  << std::endl;
+      }
+      selected_.push_back(state_.previous());
+    }
+    if (not detail::cfg::input_filename.empty()) {
+      auto in = std::ifstream{detail::cfg::input_filename};
+      auto paths = detail::test_paths{};
+      for (auto line = std::string{}; std::getline(in, line);) {
+        if (not line.empty()) {
+          paths.insert(detail::test_paths::from_line(line));
         }
       }
-      return true;
+      selected_.push_back(std::move(paths));
     }
+#if defined(BOOST_UT_RUN_TOOLS)
+    durations_.load(detail::cfg::run_durations_file());
+    if (not detail::cfg::time_budget.empty()) {
+      if (const auto budget = detail::parse_duration(detail::cfg::time_budget);
+          budget.count()) {
+        budget_.start(budget, durations_);
+      } else {
+        std::cerr << "--time-budget: cannot parse " << detail::cfg::time_budget
+                  << std::endl;
+      }
+    }
+#endif
+#if defined(BOOST_UT_HAS_POSIX_RUN_TOOLS)
+    if (not detail::cfg::bisect_pollution.empty()) {
+      bisect_pollution(detail::cfg::bisect_pollution);
+    }
+    thread_ = std::this_thread::get_id();
+    detail::interrupts::handle(this, [](void* current, const int sig) {
+      static_cast<runner*>(current)->interrupt(sig);
+    });
+    if (budget_) {
+      budget_.watch([this] { interrupt(SIGALRM); });
+    }
+#endif
+#if defined(BOOST_UT_RUN_TOOLS)
+    for (auto&& e : detail::journal::load(detail::cfg::resume)) {
+      resumed_.insert_or_assign(std::move(e.name), e.passed);
+    }
+    if (not detail::cfg::journal.empty() or not detail::cfg::resume.empty()) {
+      journal_.open(detail::cfg::journal.empty() ? detail::cfg::resume
+                                                 : detail::cfg::journal,
+                    /*append=*/detail::cfg::journal.empty() or
+                        detail::cfg::journal == detail::cfg::resume);
+    }
+    if (not detail::cfg::profile.empty()) {
+      profiler_.start(detail::cfg::profile);
+    }
+    if (not detail::cfg::soak.empty() and
+        not(soak_ = detail::parse_duration(detail::cfg::soak)).count()) {
+      std::cerr << "--soak: cannot parse " << detail::cfg::soak << std::endl;
+    }
+    if (not detail::cfg::replay.empty()) {
+      // the tests of a single worker, as the others ran concurrently: the
+      // one of the last failure or else of the last (e.g. crashed) test
+      const auto entries = detail::journal::load(detail::cfg::replay);
+      const auto failed = std::find_if(entries.crbegin(), entries.crend(),
+                                       [](const auto& e) { return not e.passed; });
+      if (not entries.empty()) {
+        const auto worker =
+            (failed != entries.crend() ? *failed : entries.back()).worker;
+        for (const auto& e : entries) {
+          if (e.worker == worker) {
+            replayed_.emplace(e.ordinal, e.name);
+          }
+        }
+      }
+      replaying_ = true;
+    }
+#endif
+    if (not detail::cfg::trace_markers.empty() and
+        not detail::trace::markers(detail::cfg::trace_markers)) {
+      std::cerr << "--trace-markers: cannot open " << detail::cfg::trace_markers
+                << std::endl;
+    }
+    run_suites();
+#if defined(BOOST_UT_RUN_TOOLS)
+    replaying_ = {};
+#endif
+    suites_.clear();
 
-   private:
-    std::vector<std::string_view> path_{};
-  };
-
- public:
-  constexpr runner() = default;
-  constexpr runner(TReporter reporter, std::size_t suites_size)
-      : reporter_{std::move(reporter)}, suites_(suites_size) {}
+    if (rc.report_errors) {
+      report_summary();
+    }
 
-  ~runner() {
-    const auto should_run = not run_;
+    return fails_ > 0;
+  }
 
-    if (should_run) {
-      static_cast<void>(run());
+  auto report_summary() -> void {
+    const auto lock = std::scoped_lock{reporting_};
+    if (static auto once = true; once) {
+      once = false;
+      summarized_ = true;
+      if (not dry_run_) {
+        state_.save(detail::cfg::run_state_file());
+#if defined(BOOST_UT_RUN_TOOLS)
+        durations_.save();
+#endif
+      }
+#if defined(BOOST_UT_RUN_TOOLS)
+      journal_.close();
+#endif
+      report(events::summary{});
+#if defined(BOOST_UT_RUN_TOOLS)
+      if (budget_) {
+        budget_.report(std::cerr);
+      }
+#endif
+      if (fails_ and detail::rng_::used) {
+        std::cerr << "rng seed: " << detail::rng_::seed()
+                  << " (reproduce with --rng-seed " << detail::rng_::seed()
+                  << ")" << std::endl;
+      }
     }
+  }
 
-    if (not dry_run_) {
-      report_summary();
+ protected:
+#if defined(__cpp_exceptions)
+  /// reports the passing assertions counted by a worker
+  auto report_passes(std::size_t passes) -> void {
+    if constexpr (subscribed<events::assertion_pass<bool>>) {
+      while (passes--) {
+        report(events::assertion_pass<bool>{.expr = true});
+      }
     }
+  }
 
-    if (should_run and fails_) {
-      std::exit(-1);
+  /// makes a call of a thread of a load test, one at a time, as the thread
+  /// of the test would (recording it too if that is a parallel child)
+  template <class F>
+  auto serialized(const F& call) -> decltype(call()) {
+    const std::scoped_lock lock{load_.mutex};
+    struct restore {
+      ~restore() { recording_ = calls; }
+      recording* calls{};
+    } const worker{std::exchange(recording_, load_.parent)};
+    return call();
+  }
+#endif
+
+  // kept out of the inlined path of assertions
+  template <class TExpr>
+  BOOST_UT_NOINLINE auto fail_assertion(
+      const events::assertion<TExpr>& assertion) -> bool {
+#if defined(__cpp_exceptions)
+    if (recording_) {
+      if (recording_->load) {
+        return serialized([&] { return on(assertion); });
+      }
+      recording_->calls.emplace_back(
+          [this, assertion] { void(on(assertion)); });
+      return false;
+    }
+#endif
+    ++fails_;
+    detail::trace::assertion_fail(
+        assertion.location.file_name(),
+        static_cast<std::size_t>(assertion.location.line()));
+    if constexpr (subscribed<events::assertion_fail<TExpr>>) {
+      report(events::assertion_fail<TExpr>{.expr = assertion.expr,
+                                           .location = assertion.location});
     }
+    return false;
   }
 
-  auto operator=(const options& options) {
-    filter_ = options.filter;
-    tag_ = options.tag;
-    dry_run_ = options.dry_run;
-    reporter_ = {options.colors};
+#if defined(__cpp_exceptions)
+  /// calls to the runner of a test run by a worker of parallel_children,
+  /// replayed by the runner thread in declaration order
+  struct recording {
+    std::vector<std::function<void()>> calls{};
+    std::exception_ptr exception{};
+    std::size_t passes{};  // assertions, which are not recorded one by one
+    bool load{};  // of a thread of a load test, never recorded, see serialized
+  };
+  struct child {
+    std::function<void()> run{};     // on a worker
+    std::function<void()> report{};  // afterwards, in declaration order
+  };
+  struct parallel {
+    std::size_t level{};  // of the parent
+    std::vector<child> children{};
+  };
+
+#endif
+#if defined(__cpp_exceptions)
+  using recorded_test = events::test<std::function<void()>>;
+
+  /// `test` with its body type-erased into `run`, so that recording tests is
+  /// compiled once rather than for every type of test
+  template <class TTest, class TRun>
+  static auto erased(const TTest& test, TRun run) -> recorded_test {
+    return {.type = test.type,
+            .name = test.name,
+            .tag = test.tag,
+            .max_stack = test.max_stack,
+            .location = test.location,
+            .arg = none{},
+            .run = std::move(run)};
+  }
+
+  /// defers a child of a parallel_children scope, which runs on a worker
+  auto defer(const recorded_test& test) -> void {
+    auto recorded = std::make_shared<recording>();
+    parallel_.back().children.push_back(
+        {.run =
+             [this, test, recorded, rng_path = detail::rng_::path] {
+               recording_ = recorded.get();
+               detail::rng_::path = rng_path;
+               record(test);
+               recording_ = {};
+             },
+         .report = [this, recorded] { replay(*recorded); }});
+  }
+
+  /// runs a test on a worker, recording the calls to the runner
+  auto record(const recorded_test& test) -> void {
+    auto recorded = std::make_shared<recording>();
+    if (std::none_of(test.tag.cbegin(), test.tag.cend(), [](const auto& tag) {
+          return utility::is_match(tag, "skip");
+        })) {
+      const auto parent = std::exchange(recording_, recorded.get());
+      const auto rng_path = std::exchange(
+          detail::rng_::path, detail::rng_::nested(detail::rng_::path, test.name));
+      try {
+        test.run();
+      } catch (const events::fatal_assertion&) {
+      } catch (...) {
+        recorded->exception = std::current_exception();
+      }
+      detail::rng_::path = rng_path;
+      recording_ = parent;
+    }
+    recording_->calls.emplace_back([this, type = test.type, name = test.name,
+                                    tag = test.tag, location = test.location,
+                                    recorded] {
+      on(recorded_test{
+          .type = type,
+          .name = name,
+          .tag = tag,
+          .location = location,
+          .arg = none{},
+          .run = [this, recorded] { replay(*recorded); }});
+    });
   }
 
-  template <class TSuite>
-  auto on(events::suite<TSuite> suite) {
-    suites_.emplace_back(suite.run, suite.name);
+  auto replay(const recording& recorded) -> void {
+    for (const auto& call : recorded.calls) {
+      call();
+    }
+    report_passes(recorded.passes);
+    if (recorded.exception) {
+      std::rethrow_exception(recorded.exception);
+    }
   }
+#endif
 
-  template <class... Ts>
-  auto on(events::test<Ts...> test) {
-    path_[level_] = test.name;
+  /// a selected test as run_test sees it, whatever the type of its body, so
+  /// that running tests is compiled once rather than for every type of test
+  struct selected_test {
+    std::string_view type{};
+    std::string_view name{};
+    std::size_t max_stack{};
+    reflection::source_location location{};
+    void (*body)(void*){};
+    void* test{};
+  };
 
-    if (detail::cfg::list_tags) {
-      std::for_each(test.tag.cbegin(), test.tag.cend(), [](const auto& tag) {
-        std::cout << "tag: " << tag << std::endl;
-      });
-      return;
+  /// reports the run of a selected test
+  auto run_test(const selected_test& test) -> void {
+    const auto level = level_;
+    const auto fails = fails_;
+    const auto nested_failure = std::exchange(nested_failure_, false);
+    if (not level) {
+      state_.ran(test.name);
+#if defined(BOOST_UT_RUN_TOOLS)
+      if (const auto resumed = resumed_.find(std::string{test.name});
+          resumed != resumed_.cend()) {
+        report(events::test_begin{
+            .type = test.type, .name = test.name, .location = test.location});
+        if (not resumed->second) {
+          ++fails_;
+          report(events::exception{"failed before the run was resumed"});
+          state_.failed({std::string{test.name}});
+        }
+        report(events::test_end{.type = test.type, .name = test.name});
+        return;
+      }
+#endif
     }
 
-    auto execute = std::empty(test.tag);
-    for (const auto& tag_element : test.tag) {
-      if (utility::is_match(tag_element, "skip") && !detail::cfg::show_tests &&
-          !detail::cfg::show_test_names) {
-        on(events::skip<>{.type = test.type, .name = test.name});
-        return;
+    ++level_;
+#if defined(BOOST_UT_HAS_POSIX_RUN_TOOLS)
+    publish_path();
+#endif
+    if (not level) {
+      report_metrics();  // recorded outside of any test
+      if (not virtual_clock::reset()) {
+        std::cerr << test.name
+                  << ": virtual_clock not reset, threads of an earlier test "
+                     "still sleep on it"
+                  << std::endl;
+      }
+#if defined(BOOST_UT_RUN_TOOLS)
+      if (detail::cfg::leak_check != "off") {
+        resources_ = detail::resources::snapshot();
       }
+#endif
+      report(events::test_begin{
+          .type = test.type, .name = test.name, .location = test.location});
+#if defined(BOOST_UT_RUN_TOOLS)
+      profiler_.begin();
+#endif
+    } else {
+      report_metrics();
+      report(events::test_run{.type = test.type, .name = test.name});
+    }
+    detail::trace::test_begin(test.name);
+#if defined(BOOST_UT_RUN_TOOLS)
+    const auto started = std::chrono::steady_clock::now();
+#endif
 
-      for (const auto& ftag : tag_) {
-        if (utility::is_match(tag_element, ftag)) {
-          execute = true;
-          break;
-        }
+    if (dry_run_) {
+      for (auto i = 0u; i < level_; ++i) {
+        std::cout << (i ? "." : "") << path_[i];
       }
+      std::cout << '\n';
     }
 
-    if (!detail::cfg::query_pattern.empty()) {
-      const static auto regex = detail::cfg::query_regex_pattern;
-      bool matches = utility::regex_match(test.name.data(), regex.c_str());
-      for (const auto& tag2 : test.tag) {
-        matches |= utility::regex_match(tag2.data(), regex.c_str());
+    const auto rng_path = std::exchange(
+        detail::rng_::path, detail::rng_::nested(detail::rng_::path, test.name));
+    auto guarded = [&] {
+#if defined(__cpp_exceptions)
+      try {
+#endif
+        test.body(test.test);
+#if defined(__cpp_exceptions)
+      } catch (const events::fatal_assertion&) {
+      } catch (const std::exception& exception) {
+        ++fails_;
+        report(events::exception{exception.what()});
+      } catch (...) {
+        ++fails_;
+        report(events::exception{"Unknown exception"});
       }
-      if (matches) {
-        execute = !detail::cfg::invert_query_pattern;
+#endif
+    };
+    auto once = [&] {
+      if (not level and (test.max_stack or detail::cfg::stack_usage)) {
+        run_on_painted_stack(guarded, test.max_stack);
       } else {
-        execute = detail::cfg::invert_query_pattern;
+        guarded();
       }
+    };
+#if defined(BOOST_UT_RUN_TOOLS)
+    if (not level and soak_.count()) {
+      soak(once, fails);
+    } else {
+      once();
     }
+#else
+    once();
+#endif
 
-    if (detail::cfg::show_tests || detail::cfg::show_test_names) {
-      if (!detail::cfg::show_test_names) {
-        std::cout << "matching test: ";
-      }
-      std::cout << test.name << std::endl;
-      return;
+    detail::rng_::path = rng_path;
+#if defined(BOOST_UT_RUN_TOOLS)
+    if (level_ == 1 and detail::cfg::leak_check != "off") {
+      check_leaks();
     }
-
-    if (not execute) {
-      on(events::skip<>{.type = test.type, .name = test.name});
-      return;
+#endif
+    report_metrics();
+    if (fails_ > fails and not nested_failure_) {
+      state_.failed({path_.cbegin(), path_.cbegin() + level + 1});
+    }
+    nested_failure_ = nested_failure or fails_ > fails;
+    detail::trace::test_end(test.name, fails_ == fails);
+#if defined(BOOST_UT_RUN_TOOLS)
+    if (not dry_run_ and not bisect_.active and not soak_.count()) {
+      track_duration(level, started, fails_ == fails);
     }
+#endif
 
-    if (filter_(level_, path_)) {
-      if (not level_++) {
-        reporter_.on(events::test_begin{
-            .type = test.type, .name = test.name, .location = test.location});
-      } else {
-        reporter_.on(events::test_run{.type = test.type, .name = test.name});
+    --level_;
+#if defined(BOOST_UT_HAS_POSIX_RUN_TOOLS)
+    publish_path();
+#endif
+    if (not level_) {
+#if defined(BOOST_UT_RUN_TOOLS)
+      profiler_.end(test.name);
+      if (journal_ and not bisect_.active and not dry_run_) {
+        journal_.append({.worker = detail::journal::worker(),
+                         .passed = fails_ == fails,
+                         .ordinal = declared_ - 1,
+                         .name = std::string{test.name}});
+      }
+#endif
+      report(events::test_end{.type = test.type, .name = test.name});
+#if defined(BOOST_UT_RUN_TOOLS)
+      if (bisect_.active and test.name == bisect_.victim) {
+        std::_Exit(fails_ > fails ? 1 : 0);
+      }
+#endif
+    } else {  // N.B. prev. only root-level tests were signalled on finish
+      if constexpr (requires {
+                      reporter_.on(events::test_finish{.type = test.type,
+                                                       .name = test.name});
+                    }) {
+        report(events::test_finish{.type = test.type, .name = test.name});
       }
+    }
+  }
 
-      if (dry_run_) {
-        for (auto i = 0u; i < level_; ++i) {
-          std::cout << (i ? "." : "") << path_[i];
-        }
-        std::cout << '\n';
+#if defined(BOOST_UT_RUN_TOOLS)
+  /// records the duration of the test at `level` of path_, warning when it
+  /// passed but took much longer than in the previous runs
+  auto track_duration(const std::size_t level,
+                      const std::chrono::steady_clock::time_point started,
+                      const bool passed) -> void {
+    const auto took = std::chrono::duration_cast<detail::durations::duration>(
+        std::chrono::steady_clock::now() - started);
+    const auto key = detail::test_paths::to_line(
+        {path_.cbegin(), path_.cbegin() + level + 1});
+    if (const auto slowdown = durations_.slowdown(key, took);
+        passed and not slowdown.empty()) {
+      for (auto i = 0u; i <= level; ++i) {
+        std::cerr << (i ? "." : "") << path_[i];
       }
+      std::cerr << ": " << slowdown << std::endl;
+    }
+    durations_.append(key, {.took = took, .passed = passed});
+  }
+#endif
 
+  /// runs a top-level test on a painted stack, reporting its use as the
+  /// `stack` gauge and failing it when it exceeds `budget` (if any)
+  template <class F>
+  auto run_on_painted_stack(F& f, const std::size_t budget) -> void {
+#if __has_include(<ucontext.h>) and __has_include(<sys/mman.h>)
+    auto stack = detail::painted_stack{std::max<std::size_t>(
+        {detail::cfg::stack_usage, 2 * budget, 256 * 1024})};
+    if (not stack) {
+      f();
+      return;
+    }
+    // the overflow jumps out of any nested tests, unwound as they were
+    const auto level = level_;
+    const auto rng_path = detail::rng_::path;
+    const auto traced = detail::trace::depth();
 #if defined(__cpp_exceptions)
-      try {
+    auto* const recorded = recording_;
+    const auto parallels = parallel_.size();
 #endif
-        test();
+    const auto used = stack.run(f);
+    if (not used) {
+      ++fails_;
+      state_.failed({path_.cbegin(), path_.cbegin() + level_});
+      nested_failure_ = level_ > level;
+      const auto message = "overflowed its stack of " +
+                           std::to_string(stack.size()) + " bytes";
+      report(events::exception{message.c_str()});
+      for (; level_ > level; --level_) {
+        if constexpr (requires { reporter_.on(events::test_finish{}); }) {
+          report(
+              events::test_finish{.type = "test", .name = path_[level_ - 1]});
+        }
+      }
+      detail::rng_::path = rng_path;
+      detail::trace::unwind(traced);
 #if defined(__cpp_exceptions)
-      } catch (const events::fatal_assertion&) {
-      } catch (const std::exception& exception) {
-        ++fails_;
-        reporter_.on(events::exception{exception.what()});
-      } catch (...) {
-        ++fails_;
-        reporter_.on(events::exception{"Unknown exception"});
+      recording_ = recorded;
+      diverted_ = dry_run_ or recording_;
+      parallel_.erase(parallel_.begin() + static_cast<std::ptrdiff_t>(parallels),
+                      parallel_.end());
+#endif
+#if defined(BOOST_UT_HAS_POSIX_RUN_TOOLS)
+      publish_path();
+#endif
+      return;
+    }
+    detail::metrics::get("stack", detail::metrics::kind::gauge)
+        .set(static_cast<double>(*used));
+    if (budget and *used > budget) {
+      ++fails_;
+      const auto message = "used " + std::to_string(*used) +
+                           " bytes of stack, more than max_stack(" +
+                           std::to_string(budget) + ")";
+      report(events::exception{message.c_str()});
+    }
+#else
+    static_cast<void>(budget);
+    f();
+#endif
+  }
+
+#if defined(BOOST_UT_RUN_TOOLS)
+  /// runs a top-level test over and over for --soak, as long as it passes,
+  /// failing it when its resources or the duration of an iteration grow
+  template <class F>
+  auto soak(F& once, const std::size_t fails) -> void {
+    using clock = detail::soak::clock;
+    auto samples = detail::soak{soak_};
+    do {
+      const auto start = clock::now();
+      once();
+      samples.iteration(clock::now() - start);
+    } while (fails_ == fails and not samples.done());
+    if (const auto message = samples.verdict();
+        fails_ == fails and not message.empty()) {
+      ++fails_;
+      report(events::exception{message.c_str()});
+    }
+  }
+
+  /// reports what the current top-level test left behind, see --leak-check
+  auto check_leaks() -> void {
+    auto leaked = detail::resources::snapshot().leaked_since(resources_);
+    // exiting threads and closed fds may take a moment to disappear
+    for (auto delay = std::chrono::microseconds{100};
+         not leaked.empty() and delay < std::chrono::milliseconds{100};
+         delay *= 2) {
+      std::this_thread::sleep_for(delay);
+      leaked = detail::resources::snapshot().leaked_since(resources_);
+    }
+    if (leaked.empty()) {
+      return;
+    }
+    auto message = std::string{"leaked "};
+    for (const auto& what : leaked) {
+      message += (&what == leaked.data() ? "" : ", ") + what;
+    }
+    if (detail::cfg::leak_check == "fail") {
+      ++fails_;
+      report(events::exception{message.c_str()});
+    } else {
+      std::cerr << path_[0] << ": " << message << std::endl;
+    }
+    resources_ = detail::resources::snapshot();
+  }
+#endif
+
+  auto run_suites() -> void {
+    for (const auto& [suite, suite_name] : suites_) {
+      // add reporter in/out
+      if constexpr (requires { reporter_.on(events::suite_begin{}); }) {
+        report(events::suite_begin{.type = "suite", .name = suite_name});
+      }
+      detail::trace::suite_begin(suite_name);
+      suite_ = suite_name;
+      suite();
+      suite_ = "global";
+      detail::trace::suite_end(suite_name);
+#if defined(BOOST_UT_RUN_TOOLS)
+      profiler_.flush(suite_name, std::cerr);
+#endif
+      if constexpr (requires { reporter_.on(events::suite_end{}); }) {
+        report(events::suite_end{.type = "suite", .name = suite_name});
       }
-#endif
+    }
+  }
 
-      if (not--level_) {
-        reporter_.on(events::test_end{.type = test.type, .name = test.name});
-      } else {  // N.B. prev. only root-level tests were signalled on finish
-        if constexpr (requires {
-                        reporter_.on(events::test_finish{.type = test.type,
-                                                         .name = test.name});
-                      }) {
-          reporter_.on(
-              events::test_finish{.type = test.type, .name = test.name});
-        }
+#if defined(BOOST_UT_HAS_POSIX_RUN_TOOLS)
+  /// whether a top-level test runs in a --bisect-pollution child
+  auto bisect_select(std::string_view name) -> bool {
+    if (name == bisect_.victim) {
+      if (bisect_.discover >= 0) {
+        std::_Exit(0);
       }
+      return true;
+    }
+    const auto ordinal = bisect_.ordinal++;
+    if (bisect_.discover >= 0) {
+      const auto line = std::string{name} + '\n';
+      static_cast<void>(write(bisect_.discover, line.data(), line.size()));
+      return false;
     }
+    return std::binary_search(bisect_.tests.cbegin(), bisect_.tests.cend(),
+                              ordinal);
   }
 
-  template <class... Ts>
-  auto on(events::skip<Ts...> test) {
-    reporter_.on(events::test_skip{.type = test.type, .name = test.name});
+  /// runs the suites in a quiet child process, see bisect_select
+  auto bisect_fork(const std::vector<std::size_t>& tests, const int discover)
+      -> pid_t {
+    std::cout.flush();
+    std::cerr.flush();
+    const auto pid = fork();
+    if (not pid) {
+      static_cast<void>(std::freopen("/dev/null", "w", stdout));
+      static_cast<void>(std::freopen("/dev/null", "w", stderr));
+      bisect_.tests = tests;
+      bisect_.discover = discover;
+      run_suites();
+      std::_Exit(2);  // victim not reached
+    }
+    return pid;
+  }
+
+  /// on the watcher thread of detail::interrupts (or of the time budget):
+  /// the runner thread reports the interrupt at its next event (other than a
+  /// passing assertion) and exits. A test which gets to none within
+  /// `interrupt_grace` is stuck, only its path is then written from here, the
+  /// reporter is left to the runner thread which may still be using it.
+  auto interrupt(const int sig) -> void {
+    interrupt_.store(sig);
+    const auto until = std::chrono::steady_clock::now() + interrupt_grace;
+    while (interrupt_.load() == sig and std::chrono::steady_clock::now() < until) {
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    if (auto pending = sig; interrupt_.compare_exchange_strong(pending, -1)) {
+      const auto lock = std::scoped_lock{reporting_};  // not amid the summary
+      if (not summarized_) {
+        const auto running_lock = std::scoped_lock{running_.mutex};
+        std::cerr << '\n' << interruption(sig);
+        if (not running_.path.empty()) {
+          std::cerr << ": \"" << running_.path << "\" did not return within "
+                    << interrupt_grace.count() << "ms";
+        }
+        std::cerr << std::endl;
+      }
+      std::_Exit(128 + sig);
+    }
+    for (;;) {  // the runner thread reports it and exits
+      std::this_thread::sleep_for(std::chrono::hours{1});
+    }
   }
 
-  template <class TExpr>
-  [[nodiscard]] auto on(events::assertion<TExpr> assertion) -> bool {
-    if (dry_run_) {
-      return true;
+  /// on the runner thread, reports the pending interrupt and exits. Other
+  /// threads return, they may hold locks which the test needs to get there.
+  BOOST_UT_NOINLINE auto claim_interrupt() -> void {
+    if (std::this_thread::get_id() != thread_) {
+      return;
     }
-
-    if (static_cast<bool>(assertion.expr)) {
-      reporter_.on(events::assertion_pass<TExpr>{
-          .expr = assertion.expr, .location = assertion.location});
-      return true;
+    if (auto sig = interrupt_.load(); sig > 0 and
+                                      interrupt_.compare_exchange_strong(sig, -1)) {
+      interrupted(sig);
     }
+  }
 
-    ++fails_;
-    reporter_.on(events::assertion_fail<TExpr>{.expr = assertion.expr,
-                                               .location = assertion.location});
-    return false;
+  [[nodiscard]] static auto interruption(const int sig) -> const char* {
+    return sig == SIGALRM  ? "exceeded the time budget"
+           : sig == SIGINT ? "interrupted by SIGINT"
+                           : "interrupted by SIGTERM";
   }
 
-  auto on(events::fatal_assertion fatal_assertion) {
-    reporter_.on(fatal_assertion);
+  /// the path of the running test, as written by interrupt when it is stuck
+  auto publish_path() -> void {
+    const auto lock = std::scoped_lock{running_.mutex};
+    running_.path.clear();
+    for (auto i = 0u; i < level_; ++i) {
+      (running_.path += i ? "." : "") += path_[i];
+    }
+  }
 
-#if defined(__cpp_exceptions)
-    if (not level_) {
-      report_summary();
+  /// reports the running test as interrupted, followed by the summary
+  [[noreturn]] auto interrupted(const int sig) -> void {
+    const auto lock = std::scoped_lock{reporting_};
+    if (summarized_) {
+      std::_Exit(128 + sig);
     }
-    throw fatal_assertion;
-#else
     if (level_) {
-      reporter_.on(events::test_end{});
+      ++fails_;
+      state_.failed({path_.cbegin(), path_.cbegin() + level_});
+      profiler_.end(path_[0]);
+    }
+    profiler_.flush(suite_, std::cerr);  // the samples so far
+    if constexpr (requires {
+                    reporter_.on(events::exception{});
+                    reporter_.on(events::test_end{});
+                  }) {
+      if (level_) {
+        report(events::exception{interruption(sig)});
+        for (auto level = level_; --level;) {
+          if constexpr (requires { reporter_.on(events::test_finish{}); }) {
+            report(events::test_finish{.type = "test", .name = path_[level]});
+          }
+        }
+        report(events::test_end{.type = "test", .name = path_[0]});
+      }
     }
     report_summary();
-    std::abort();
-#endif
+    std::cout.flush();
+    std::cerr.flush();
+    std::_Exit(128 + sig);
   }
 
-  template <class TMsg>
-  auto on(events::log<TMsg> l) {
-    reporter_.on(l);
-  }
+  auto bisect_pollution(std::string_view victim) -> void {
+    const auto log = [](const auto&... args) {
+      ((std::cerr << "bisect-pollution: ") << ... << args) << std::endl;
+    };
+    const auto exit = [this](const int code) {
+      dry_run_ = true;  // no summary
+      std::exit(code);
+    };
+    bisect_.victim = victim;
+    bisect_.active = true;
 
-  [[nodiscard]] auto run(run_cfg rc = {}) -> bool {
-    run_ = true;
-    reporter_.on(events::run_begin{.argc = rc.argc, .argv = rc.argv});
-    for (const auto& [suite, suite_name] : suites_) {
-      // add reporter in/out
-      if constexpr (requires { reporter_.on(events::suite_begin{}); }) {
-        reporter_.on(events::suite_begin{.type = "suite", .name = suite_name});
-      }
-      suite();
-      if constexpr (requires { reporter_.on(events::suite_end{}); }) {
-        reporter_.on(events::suite_end{.type = "suite", .name = suite_name});
+    int fds[2]{};
+    if (pipe(fds)) {
+      log("pipe failed");
+      exit(-1);
+    }
+    const auto pid = bisect_fork({}, fds[1]);
+    close(fds[1]);
+    auto names = std::string{};
+    char buffer[4096];
+    for (ssize_t n{}; (n = read(fds[0], buffer, sizeof(buffer))) > 0;) {
+      names.append(buffer, static_cast<std::size_t>(n));
+    }
+    close(fds[0]);
+    auto status = 0;
+    waitpid(pid, &status, 0);
+    if (not WIFEXITED(status) or WEXITSTATUS(status)) {
+      log("test \"", victim, "\" not found");
+      exit(-1);
+    }
+    const auto before = utility::split<std::string>(names, "\n");
+    auto tests = std::vector<std::size_t>(before.size());
+    for (auto i = 0u; i < tests.size(); ++i) {
+      tests[i] = i;
+    }
+
+    auto probes = 0u;
+    auto fails = [&](const std::vector<std::size_t>& ordinals) {
+      ++probes;
+      auto probe_status = 0;
+      waitpid(bisect_fork(ordinals, -1), &probe_status, 0);
+      if (WIFEXITED(probe_status) and WEXITSTATUS(probe_status) == 2) {
+        log("test \"", victim, "\" was not run");
+        exit(-1);
       }
+      return probe_status != 0;
+    };
+
+    if (not fails(tests)) {
+      log("\"", victim, "\" passes after the ", tests.size(),
+          " tests declared before it");
+      exit(-1);
+    }
+    if (fails({})) {
+      log("\"", victim, "\" fails on its own");
+      exit(-1);
     }
-    suites_.clear();
 
-    if (rc.report_errors) {
-      report_summary();
+    auto culprits = std::string{};
+    for (const auto ordinal : detail::bisect_pollution(tests, fails)) {
+      culprits += (culprits.empty() ? "\"" : ", \"") + before[ordinal] + '"';
     }
+    log("\"", victim, "\" fails after ", culprits, " (", probes, " probes)");
+    exit(0);
+  }
+#endif
 
-    return fails_ > 0;
+  auto report_metrics() -> void {
+    detail::metrics::drain([this](const events::metric& metric) {
+      if constexpr (requires { reporter_.on(metric); }) {
+        report(metric);
+      }
+    });
   }
 
-  auto report_summary() -> void {
-    if (static auto once = true; once) {
-      once = false;
-      reporter_.on(events::summary{});
+  template <class TEvent>
+  static constexpr auto subscribed = detail::is_subscribed<TReporter, TEvent>;
+
+  template <class TEvent>
+  BOOST_UT_ALWAYS_INLINE auto report(const TEvent& event) -> void {
+    if constexpr (subscribed<TEvent>) {
+#if defined(BOOST_UT_HAS_POSIX_RUN_TOOLS)
+      if constexpr (not detail::is_event<TEvent, events::assertion_pass<>>) {
+        if (interrupt_.load(std::memory_order_relaxed)) {
+          claim_interrupt();
+        }
+      }
+#endif
+      reporter_.on(event);
     }
   }
 
- protected:
   TReporter reporter_{};
   std::vector<std::pair<void (*)(), std::string_view>> suites_{};
+  std::string_view suite_{"global"};  // running
   std::size_t level_{};
   bool run_{};
   std::size_t fails_{};
@@ -2238,6 +5969,53 @@ class runner {
   filter filter_{};
   std::vector<std::string_view> tag_{};
   bool dry_run_{};
+  bool diverted_{};  // a dry run, or tests run on workers: see on(assertion)
+  detail::run_state state_{};
+  std::vector<detail::test_paths> selected_{};  // tests must match all
+  std::ofstream list_{};
+  bool nested_failure_{};
+#if defined(BOOST_UT_RUN_TOOLS)
+  detail::journal journal_{};
+  detail::resources resources_{};
+  detail::profiler profiler_{};
+  detail::soak::clock::duration soak_{};  // per top-level test
+  detail::durations durations_{};
+  detail::time_budget budget_{};
+#endif
+#if defined(__cpp_exceptions)
+  static inline thread_local recording* recording_{};
+  std::vector<parallel> parallel_{};
+  struct {
+    std::deque<recording> calls{};  // of each thread
+    recording* parent{};
+    std::mutex mutex{};
+    std::size_t depth{};  // of nested load tests
+  } load_{};
+#endif
+#if defined(BOOST_UT_HAS_POSIX_RUN_TOOLS)
+  static constexpr auto interrupt_grace = std::chrono::milliseconds{100};
+  std::atomic<int> interrupt_{};  // signal, -1 once claimed
+  std::thread::id thread_{};      // of the runner, which reports interrupts
+  struct {
+    std::mutex mutex{};
+    std::string path{};
+  } running_{};  // see publish_path
+#endif
+  std::recursive_mutex reporting_{};  // summarizing, see interrupted
+  bool summarized_{};
+  std::size_t declared_{};  // top-level tests
+#if defined(BOOST_UT_RUN_TOOLS)
+  std::unordered_map<std::string, bool> resumed_{};  // name -> passed
+  bool replaying_{};
+  std::unordered_map<std::size_t, std::string> replayed_{};  // by ordinal
+  struct {
+    std::string_view victim{};
+    bool active{};
+    int discover{-1};  // receives the names of the tests before the victim
+    std::vector<std::size_t> tests{};  // ordinals of the tests to run
+    std::size_t ordinal{};
+  } bisect_{};
+#endif
 };
 
 struct override {};
@@ -2249,14 +6027,26 @@ template <class = override, class...>
 namespace detail {
 struct tag {
   std::vector<std::string_view> name{};
+  std::size_t max_stack{};
 };
 
 template <class... Ts, class TEvent>
-[[nodiscard]] constexpr decltype(auto) on(TEvent&& event) {
+[[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr decltype(auto) on(
+    TEvent&& event) {
+  const allocations::pause pause{};
   return ut::cfg<typename type_traits::identity<override, Ts...>::type>.on(
       static_cast<TEvent&&>(event));
 }
 
+template <class... Ts>
+class parallel_children_ {
+ public:
+  parallel_children_() { on<Ts...>(events::parallel_begin{}); }
+  parallel_children_(const parallel_children_&) = delete;
+  parallel_children_& operator=(const parallel_children_&) = delete;
+  ~parallel_children_() { on<Ts...>(events::parallel_end{}); }
+};
+
 template <class Test>
 struct test_location {
   template <class T>
@@ -2273,12 +6063,14 @@ struct test {
   std::string_view type{};
   std::string_view name{};
   std::vector<std::string_view> tag{};
+  std::size_t max_stack{};
 
   template <class... Ts>
   constexpr auto operator=(test_location<void (*)()> _test) {
     on<Ts...>(events::test<void (*)()>{.type = type,
                                        .name = std::string{name},
                                        .tag = tag,
+                                       .max_stack = max_stack,
                                        .location = _test.location,
                                        .arg = none{},
                                        .run = _test.test});
@@ -2291,6 +6083,7 @@ struct test {
     on<Test>(events::test<Test>{.type = type,
                                 .name = std::string{name},
                                 .tag = tag,
+                                .max_stack = max_stack,
                                 .location = {},
                                 .arg = none{},
                                 .run = static_cast<Test&&>(_test)});
@@ -2372,37 +6165,43 @@ struct that_ {
   struct expr {
     using type = expr;
 
-    constexpr explicit expr(const T& t) : t_{t} {}
+    BOOST_UT_ALWAYS_INLINE constexpr explicit expr(const T& t) : t_{t} {}
 
     [[nodiscard]] constexpr auto operator!() const { return not_{*this}; }
 
     template <class TRhs>
-    [[nodiscard]] constexpr auto operator==(const TRhs& rhs) const {
+    [[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto operator==(
+        const TRhs& rhs) const {
       return eq_{t_, rhs};
     }
 
     template <class TRhs>
-    [[nodiscard]] constexpr auto operator!=(const TRhs& rhs) const {
+    [[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto operator!=(
+        const TRhs& rhs) const {
       return neq_{t_, rhs};
     }
 
     template <class TRhs>
-    [[nodiscard]] constexpr auto operator>(const TRhs& rhs) const {
+    [[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto operator>(
+        const TRhs& rhs) const {
       return gt_{t_, rhs};
     }
 
     template <class TRhs>
-    [[nodiscard]] constexpr auto operator>=(const TRhs& rhs) const {
+    [[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto operator>=(
+        const TRhs& rhs) const {
       return ge_{t_, rhs};
     }
 
     template <class TRhs>
-    [[nodiscard]] constexpr auto operator<(const TRhs& rhs) const {
+    [[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto operator<(
+        const TRhs& rhs) const {
       return lt_{t_, rhs};
     }
 
     template <class TRhs>
-    [[nodiscard]] constexpr auto operator<=(const TRhs& rhs) const {
+    [[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto operator<=(
+        const TRhs& rhs) const {
       return le_{t_, rhs};
     }
 
@@ -2414,7 +6213,8 @@ struct that_ {
   };
 
   template <class T>
-  [[nodiscard]] constexpr auto operator%(const T& t) const {
+  [[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto operator%(
+      const T& t) const {
     return expr{t};
   }
 };
@@ -2443,7 +6243,10 @@ struct fatal_ : op {
 
 template <class T>
 struct expect_ {
-  constexpr explicit expect_(bool value) : value_{value} { cfg::wip = {}; }
+  BOOST_UT_ALWAYS_INLINE constexpr explicit expect_(
+      bool value) : value_{value} {
+    cfg::wip = {};
+  }
 
   template <class TMsg>
   auto& operator<<(const TMsg& msg) {
@@ -2469,7 +6272,9 @@ struct expect_ {
     return *this;
   }
 
-  [[nodiscard]] constexpr operator bool() const { return value_; }
+  [[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr operator bool() const {
+    return value_;
+  }
 
   bool value_{};
 };
@@ -2480,6 +6285,11 @@ namespace literals {
   return detail::test{"test", std::string_view{name, size}};
 }
 
+/// a load test, see rate
+[[nodiscard]] inline auto operator""_load(const char* name, std::size_t size) {
+  return detail::test{"load", std::string_view{name, size}};
+}
+
 template <char... Cs>
 [[nodiscard]] constexpr auto operator""_i() {
   return detail::integral_constant<math::num<int, Cs...>()>{};
@@ -2545,164 +6355,853 @@ template <char... Cs>
   return detail::integral_constant<math::num<std::int16_t, Cs...>()>{};
 }
 
-template <char... Cs>
-[[nodiscard]] constexpr auto operator""_i32() {
-  return detail::integral_constant<math::num<std::int32_t, Cs...>()>{};
-}
+template <char... Cs>
+[[nodiscard]] constexpr auto operator""_i32() {
+  return detail::integral_constant<math::num<std::int32_t, Cs...>()>{};
+}
+
+template <char... Cs>
+[[nodiscard]] constexpr auto operator""_i64() {
+  return detail::integral_constant<math::num<std::int64_t, Cs...>()>{};
+}
+
+template <char... Cs>
+[[nodiscard]] constexpr auto operator""_u8() {
+  return detail::integral_constant<math::num<std::uint8_t, Cs...>()>{};
+}
+
+template <char... Cs>
+[[nodiscard]] constexpr auto operator""_u16() {
+  return detail::integral_constant<math::num<std::uint16_t, Cs...>()>{};
+}
+
+template <char... Cs>
+[[nodiscard]] constexpr auto operator""_u32() {
+  return detail::integral_constant<math::num<std::uint32_t, Cs...>()>{};
+}
+
+template <char... Cs>
+[[nodiscard]] constexpr auto operator""_u64() {
+  return detail::integral_constant<math::num<std::uint64_t, Cs...>()>{};
+}
+
+template <char... Cs>
+[[nodiscard]] constexpr auto operator""_f() {
+  return detail::floating_point_constant<
+      float, math::num<unsigned long, Cs...>(),
+      math::den<unsigned long, Cs...>(),
+      math::den_size<unsigned long, Cs...>()>{};
+}
+
+template <char... Cs>
+[[nodiscard]] constexpr auto operator""_d() {
+  return detail::floating_point_constant<
+      double, math::num<unsigned long, Cs...>(),
+      math::den<unsigned long, Cs...>(),
+      math::den_size<unsigned long, Cs...>()>{};
+}
+
+template <char... Cs>
+[[nodiscard]] constexpr auto operator""_ld() {
+  return detail::floating_point_constant<
+      long double, math::num<unsigned long long, Cs...>(),
+      math::den<unsigned long long, Cs...>(),
+      math::den_size<unsigned long long, Cs...>()>{};
+}
+
+constexpr auto operator""_b(const char* name, decltype(sizeof("")) size) {
+  struct named : std::string_view, detail::op {
+    using value_type = bool;
+    [[nodiscard]] constexpr operator value_type() const { return true; }
+    [[nodiscard]] constexpr auto operator==(const named&) const { return true; }
+    [[nodiscard]] constexpr auto operator==(const bool other) const {
+      return other;
+    }
+  };
+  return named{{name, size}, {}};
+}
+}  // namespace literals
+
+[[nodiscard]] constexpr auto get_ordinal_suffix(int number) {
+  // See https://stackoverflow.com/a/13627586
+  const auto last_digit = number % 10;
+  const auto last_two_digits = number % 100;
+  if (last_digit == 1 && last_two_digits != 11) {
+    return "st";
+  }
+  if (last_digit == 2 && last_two_digits != 12) {
+    return "nd";
+  }
+  if (last_digit == 3 && last_two_digits != 13) {
+    return "rd";
+  }
+  return "th";
+};
+
+template <class TArg>
+inline std::string format_test_parameter([[maybe_unused]] const TArg& arg,
+                                         const int counter) {
+  return std::to_string(counter) + get_ordinal_suffix(counter) + " parameter";
+}
+
+template <class F>
+  requires(std::integral<F> || std::floating_point<F>) &&
+          (!std::same_as<F, bool>)
+inline std::string
+    format_test_parameter(const F& arg, [[maybe_unused]] const int counter) {
+  std::ostringstream oss;
+  oss << arg;
+  return oss.str();
+}
+
+inline std::string format_test_parameter(const bool& arg,
+                                         [[maybe_unused]] const int counter) {
+  return arg ? "true" : "false";
+}
+
+/// a row of a data file (see rows_from), fields are views into the file
+/// which is kept alive by the row
+class row {
+ public:
+  row() = default;
+  row(const std::size_t line, std::vector<std::string_view> fields,
+      std::shared_ptr<const void> file = {})
+      : line_{line}, fields_{std::move(fields)}, file_{std::move(file)} {}
+
+  [[nodiscard]] auto line() const -> std::size_t { return line_; }
+  [[nodiscard]] auto size() const -> std::size_t { return fields_.size(); }
+  [[nodiscard]] auto operator[](const std::size_t i) const -> std::string_view {
+    return fields_[i];
+  }
+
+  /// field `i` converted to T (arithmetic via from_chars, bool, strings)
+  template <class T>
+  [[nodiscard]] auto get(const std::size_t i) const -> std::optional<T> {
+    if (i >= fields_.size()) {
+      return std::nullopt;
+    }
+    const auto field = fields_[i];
+    if constexpr (std::is_same_v<T, bool>) {
+      if (field == "true" or field == "1") {
+        return true;
+      }
+      if (field == "false" or field == "0") {
+        return false;
+      }
+      return std::nullopt;
+    } else if constexpr (std::is_arithmetic_v<T>) {
+      auto value = T{};
+      const auto [end, ec] =
+          std::from_chars(field.data(), field.data() + field.size(), value);
+      if (ec != std::errc{} or end != field.data() + field.size()) {
+        return std::nullopt;
+      }
+      return value;
+    } else {
+      static_assert(std::is_constructible_v<T, std::string_view>);
+      return T{field};
+    }
+  }
+
+ private:
+  std::size_t line_{};
+  std::vector<std::string_view> fields_{};
+  std::shared_ptr<const void> file_{};
+};
+
+inline std::string format_test_parameter(const row& arg,
+                                         [[maybe_unused]] const int counter) {
+  return "line " + std::to_string(arg.line());
+}
+
+namespace detail {
+/// read-only contents of a file, memory mapped where available
+class mapped_file {
+ public:
+  explicit mapped_file(const std::string& path) {
+#if __has_include(<sys/mman.h>) and __has_include(<sys/stat.h>)
+    if (const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC); fd >= 0) {
+      struct stat info{};
+      if (not fstat(fd, &info) and info.st_size > 0) {
+        const auto size = static_cast<std::size_t>(info.st_size);
+        if (auto* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            data != MAP_FAILED) {
+          madvise(data, size, MADV_SEQUENTIAL);
+          mapped_ = {static_cast<const char*>(data), size};
+        }
+      }
+      ::close(fd);
+      if (not mapped_.empty()) {
+        return;
+      }
+    }
+#endif
+    auto in = std::ifstream{path, std::ios::binary};
+    buffer_.assign(std::istreambuf_iterator<char>{in}, {});
+  }
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+  ~mapped_file() {
+#if __has_include(<sys/mman.h>) and __has_include(<sys/stat.h>)
+    if (not mapped_.empty()) {
+      munmap(const_cast<char*>(mapped_.data()), mapped_.size());
+    }
+#endif
+  }
+
+  [[nodiscard]] auto data() const -> std::string_view {
+    return mapped_.empty() ? std::string_view{buffer_} : mapped_;
+  }
+
+ private:
+  std::string_view mapped_{};
+  std::string buffer_{};
+};
+
+/// the fields of a CSV line (quotes are stripped, "" is kept as is)
+[[nodiscard]] inline auto csv_fields(std::string_view line)
+    -> std::vector<std::string_view> {
+  auto fields = std::vector<std::string_view>{};
+  for (auto i = std::size_t{}; i <= line.size();) {
+    if (i < line.size() and line[i] == '"') {
+      auto end = i + 1;
+      while (end < line.size() and
+             (line[end] != '"' or (end + 1 < line.size() and line[end + 1] == '"' and ++end))) {
+        ++end;
+      }
+      fields.push_back(line.substr(i + 1, end - i - 1));
+      i = std::min(line.find(',', end), line.size()) + 1;
+    } else {
+      const auto end = std::min(line.find(',', i), line.size());
+      fields.push_back(line.substr(i, end - i));
+      i = end + 1;
+    }
+  }
+  return fields;
+}
+
+/// the values of a JSON line, either an array or an object (in key order);
+/// strings are not unescaped, nested arrays/objects are kept as JSON
+[[nodiscard]] inline auto json_fields(std::string_view line)
+    -> std::vector<std::string_view> {
+  auto fields = std::vector<std::string_view>{};
+  auto i = std::size_t{};
+  const auto skip_space = [&] {
+    while (i < line.size() and (line[i] == ' ' or line[i] == '\t' or line[i] == '\r')) {
+      ++i;
+    }
+  };
+  const auto string_end = [&](std::size_t pos) {  // pos after the opening "
+    while (pos < line.size() and line[pos] != '"') {
+      pos += line[pos] == '\\' ? 2 : 1;
+    }
+    return std::min(pos, line.size());
+  };
+  skip_space();
+  if (i == line.size() or (line[i] != '[' and line[i] != '{')) {
+    return fields;
+  }
+  const auto object = line[i++] == '{';
+  while (true) {
+    skip_space();
+    if (i >= line.size() or line[i] == ']' or line[i] == '}') {
+      break;
+    }
+    if (object) {  // key
+      i = string_end(i + 1) + 1;
+      skip_space();
+      ++i;  // :
+      skip_space();
+    }
+    auto begin = i;
+    if (i < line.size() and line[i] == '"') {
+      i = string_end(i + 1);
+      fields.push_back(line.substr(begin + 1, i - begin - 1));
+      ++i;
+    } else {
+      for (auto depth = 0; i < line.size(); ++i) {
+        if (line[i] == '"') {
+          i = string_end(i + 1);
+        } else if (line[i] == '[' or line[i] == '{') {
+          ++depth;
+        } else if ((line[i] == ']' or line[i] == '}') and depth-- == 0) {
+          break;
+        } else if (line[i] == ',' and not depth) {
+          break;
+        }
+      }
+      auto end = i;
+      while (end > begin and (line[end - 1] == ' ' or line[end - 1] == '\t')) {
+        --end;
+      }
+      fields.push_back(line.substr(begin, end - begin));
+    }
+    skip_space();
+    if (i < line.size() and line[i] == ',') {
+      ++i;
+    }
+  }
+  return fields;
+}
+
+/// lazily parsed rows of a CSV or JSON lines (.jsonl, .ndjson) file, empty
+/// lines and lines starting with # are skipped
+class rows_ {
+ public:
+  class iterator {
+   public:
+    using difference_type = std::ptrdiff_t;
+    using value_type = row;
 
-template <char... Cs>
-[[nodiscard]] constexpr auto operator""_i64() {
-  return detail::integral_constant<math::num<std::int64_t, Cs...>()>{};
-}
+    iterator() = default;
+    iterator(const rows_* owner, const std::size_t pos, const std::size_t line)
+        : owner_{owner}, pos_{pos}, line_{line} {
+      skip();
+    }
 
-template <char... Cs>
-[[nodiscard]] constexpr auto operator""_u8() {
-  return detail::integral_constant<math::num<std::uint8_t, Cs...>()>{};
-}
+    [[nodiscard]] auto operator*() const -> row {
+      return {line_,
+              owner_->json_ ? json_fields(current()) : csv_fields(current()),
+              owner_->file_};
+    }
+    auto operator++() -> iterator& {
+      pos_ = next();
+      ++line_;
+      skip();
+      return *this;
+    }
+    auto operator++(int) -> iterator {
+      auto it = *this;
+      ++*this;
+      return it;
+    }
+    [[nodiscard]] auto operator==(const iterator& other) const -> bool {
+      return pos_ == other.pos_;
+    }
 
-template <char... Cs>
-[[nodiscard]] constexpr auto operator""_u16() {
-  return detail::integral_constant<math::num<std::uint16_t, Cs...>()>{};
-}
+   private:
+    [[nodiscard]] auto next() const -> std::size_t {
+      const auto end = owner_->data_.find('\n', pos_);
+      return end == std::string_view::npos or end >= owner_->data_.size()
+                 ? owner_->data_.size()
+                 : end + 1;
+    }
+    [[nodiscard]] auto current() const -> std::string_view {
+      auto line = owner_->data_.substr(pos_, next() - pos_);
+      while (not line.empty() and (line.back() == '\n' or line.back() == '\r')) {
+        line.remove_suffix(1);
+      }
+      return line;
+    }
+    auto skip() -> void {
+      while (pos_ < owner_->data_.size()) {
+        const auto line = current();
+        if (not line.empty() and line.front() != '#') {
+          return;
+        }
+        pos_ = next();
+        ++line_;
+      }
+    }
 
-template <char... Cs>
-[[nodiscard]] constexpr auto operator""_u32() {
-  return detail::integral_constant<math::num<std::uint32_t, Cs...>()>{};
-}
+    friend class rows_;
+    const rows_* owner_{};
+    std::size_t pos_{};
+    std::size_t line_{};
+  };
 
-template <char... Cs>
-[[nodiscard]] constexpr auto operator""_u64() {
-  return detail::integral_constant<math::num<std::uint64_t, Cs...>()>{};
-}
+  rows_(const std::string& path, const reflection::source_location& location)
+      : file_{std::make_shared<const mapped_file>(path)},
+        data_{file_->data()},
+        path_{path},
+        location_{location},
+        json_{path.ends_with(".jsonl") or path.ends_with(".ndjson")} {}
+
+  /// the rows of shard `index` of `count` (split at line boundaries by size)
+  [[nodiscard]] auto shard(const std::size_t index, const std::size_t count) const
+      -> rows_ {
+    const auto boundary = [&](const std::size_t i) {
+      const auto at = begin_ + (data_.size() - begin_) * i / count;
+      if (at <= begin_) {
+        return begin_;
+      }
+      const auto pos = data_.find('\n', at - 1);
+      return pos == std::string_view::npos ? data_.size() : pos + 1;
+    };
+    auto rows = *this;
+    const auto begin = boundary(index);
+    rows.data_ = data_.substr(0, std::max(begin, boundary(index + 1)));
+    rows.begin_ = begin;
+    rows.first_line_ = first_line_ + static_cast<std::size_t>(std::count(
+                                         data_.begin() + static_cast<std::ptrdiff_t>(begin_),
+                                         data_.begin() + static_cast<std::ptrdiff_t>(begin), '\n'));
+    return rows;
+  }
+
+  [[nodiscard]] auto begin() const { return iterator{this, begin_, first_line_}; }
+  [[nodiscard]] auto end() const { return iterator{this, data_.size(), {}}; }
+
+  /// the rows without the first one, e.g. the header of a CSV file (call
+  /// it before shard)
+  [[nodiscard]] auto skip_header() const -> rows_ {
+    auto rows = *this;
+    if (auto it = begin(); it != end()) {
+      ++it;
+      rows.begin_ = it.pos_;
+      rows.first_line_ = it.line_;
+    }
+    return rows;
+  }
 
-template <char... Cs>
-[[nodiscard]] constexpr auto operator""_f() {
-  return detail::floating_point_constant<
-      float, math::num<unsigned long, Cs...>(),
-      math::den<unsigned long, Cs...>(),
-      math::den_size<unsigned long, Cs...>()>{};
-}
+  [[nodiscard]] auto path() const -> const std::string& { return path_; }
+  [[nodiscard]] auto location() const -> const reflection::source_location& {
+    return location_;
+  }
 
-template <char... Cs>
-[[nodiscard]] constexpr auto operator""_d() {
-  return detail::floating_point_constant<
-      double, math::num<unsigned long, Cs...>(),
-      math::den<unsigned long, Cs...>(),
-      math::den_size<unsigned long, Cs...>()>{};
+ private:
+  std::shared_ptr<const mapped_file> file_{};
+  std::string_view data_{};
+  std::string path_{};
+  reflection::source_location location_{};
+  std::size_t begin_{};
+  std::size_t first_line_{1};
+  bool json_{};
+};
+}  // namespace detail
+
+/// rows of a CSV or JSON lines file as parameters of a test, see row
+[[nodiscard]] inline auto rows_from(
+    const std::string& path, const reflection::source_location& location =
+                                 reflection::source_location::current())
+    -> detail::rows_ {
+  return detail::rows_{path, location};
 }
 
-template <char... Cs>
-[[nodiscard]] constexpr auto operator""_ld() {
-  return detail::floating_point_constant<
-      long double, math::num<unsigned long long, Cs...>(),
-      math::den<unsigned long long, Cs...>(),
-      math::den_size<unsigned long long, Cs...>()>{};
+namespace detail {
+/// smaller variants of `input`, tried when minimizing a failing input
+template <class T>
+[[nodiscard]] auto shrinks(const T& input) -> std::vector<T> {
+  auto smaller = std::vector<T>{};
+  if constexpr (std::is_same_v<T, bool>) {
+    if (input) {
+      smaller.push_back(false);
+    }
+  } else if constexpr (std::is_arithmetic_v<T>) {
+    if (input != T{}) {
+      smaller.push_back(T{});
+      if constexpr (std::is_signed_v<T>) {
+        if (input < T{}) {
+          smaller.push_back(static_cast<T>(-input));
+        }
+      }
+      if (const auto half = static_cast<T>(input / 2); half != input) {
+        smaller.push_back(half);
+      }
+      if constexpr (std::is_integral_v<T>) {
+        smaller.push_back(static_cast<T>(input < T{} ? input + 1 : input - 1));
+      }
+    }
+  } else if constexpr (requires(T t) {
+                         t.erase(t.begin(), t.end());
+                         std::ranges::size(t);
+                       }) {
+    const auto size = std::ranges::size(input);
+    for (auto chunk = size / 2 ? size / 2 : size; chunk; chunk /= 2) {
+      for (auto i = decltype(size){}; i + chunk <= size; i += chunk) {
+        auto copy = input;
+        const auto first = std::next(copy.begin(), static_cast<std::ptrdiff_t>(i));
+        copy.erase(first, std::next(first, static_cast<std::ptrdiff_t>(chunk)));
+        smaller.push_back(std::move(copy));
+      }
+    }
+    if constexpr (requires { shrinks(*input.begin()); }) {
+      for (auto i = decltype(size){}; i < size; ++i) {
+        for (auto& element : shrinks(*std::next(input.begin(), static_cast<std::ptrdiff_t>(i)))) {
+          auto copy = input;
+          *std::next(copy.begin(), static_cast<std::ptrdiff_t>(i)) = std::move(element);
+          smaller.push_back(std::move(copy));
+        }
+      }
+    }
+  }
+  return smaller;
 }
 
-constexpr auto operator""_b(const char* name, decltype(sizeof("")) size) {
-  struct named : std::string_view, detail::op {
-    using value_type = bool;
-    [[nodiscard]] constexpr operator value_type() const { return true; }
-    [[nodiscard]] constexpr auto operator==(const named&) const { return true; }
-    [[nodiscard]] constexpr auto operator==(const bool other) const {
-      return other;
+/// the smallest input found by shrinking `input` while `fails` holds
+template <class T, class TFails>
+[[nodiscard]] auto minimize(T input, TFails fails, int budget = 1'000) -> T {
+  for (auto progress = true; progress and budget > 0;) {
+    progress = false;
+    for (auto& candidate : shrinks(input)) {
+      if (budget-- <= 0) {
+        break;
+      }
+      if (fails(candidate)) {
+        input = std::move(candidate);
+        progress = true;
+        break;
+      }
     }
-  };
-  return named{{name, size}, {}};
+  }
+  return input;
 }
-}  // namespace literals
 
-[[nodiscard]] constexpr auto get_ordinal_suffix(int number) {
-  // See https://stackoverflow.com/a/13627586
-  const auto last_digit = number % 10;
-  const auto last_two_digits = number % 100;
-  if (last_digit == 1 && last_two_digits != 11) {
-    return "st";
+template <class TReference, class TCandidate, class TCompare>
+struct differential_ {
+  TReference reference{};
+  TCandidate candidate{};
+  TCompare compare{};
+  reflection::source_location location{};
+
+  template <class TInput>
+  static auto call(const auto& f, const TInput& input) -> decltype(auto) {
+    if constexpr (std::invocable<decltype(f), const TInput&>) {
+      return std::invoke(f, input);
+    } else {
+      return std::apply(f, input);
+    }
   }
-  if (last_digit == 2 && last_two_digits != 12) {
-    return "nd";
+
+  template <class TValue>
+  [[nodiscard]] static auto describe(const TValue& value) -> std::string {
+    if constexpr (concepts::ostreamable<TValue>) {
+      std::ostringstream out{};
+      out << value;
+      return out.str();
+    } else if constexpr (std::ranges::range<TValue>) {
+      auto out = std::string{"{"};
+      for (auto n = 0; const auto& element : value) {
+        if (n == 32) {
+          out += ", ...";
+          break;
+        }
+        out += (n++ ? ", " : "") + describe(element);
+      }
+      return out + '}';
+    } else {
+      return std::string{reflection::type_name<TValue>()};
+    }
   }
-  if (last_digit == 3 && last_two_digits != 13) {
-    return "rd";
+
+  /// compares the results for every input, reporting the first (minimized)
+  /// input which differs and the speedup of the candidate as a gauge
+  template <class TInputs>
+  auto operator()(const TInputs& inputs) const -> void {
+    using clock = std::chrono::steady_clock;
+    auto reference_time = clock::duration{};
+    auto candidate_time = clock::duration{};
+    const auto differs = [this](const auto& input) {
+      return not compare(call(reference, input), call(candidate, input));
+    };
+    for (const auto& input : inputs) {
+      const auto start = clock::now();
+      const auto expected = call(reference, input);
+      const auto middle = clock::now();
+      const auto actual = call(candidate, input);
+      reference_time += middle - start;
+      candidate_time += clock::now() - middle;
+      if (not compare(expected, actual)) {
+        using input_t = std::remove_cvref_t<decltype(input)>;
+        const auto minimized = minimize(input_t{input}, differs);
+        auto message = " candidate differs from reference for " + describe(minimized);
+        if constexpr (std::equality_comparable<input_t>) {
+          if (not (minimized == input)) {
+            message += " (minimized from " + describe(input) + ")";
+          }
+        }
+        message += ": " + describe(call(reference, minimized)) + " != " +
+                   describe(call(candidate, minimized));
+        void(on<TInputs>(
+            events::assertion<bool>{.expr = false, .location = location}));
+        on<TInputs>(events::log{message});
+        return;
+      }
+    }
+    if (candidate_time.count()) {
+      metrics::get("speedup", metrics::kind::gauge)
+          .set(std::chrono::duration<double>(reference_time).count() /
+               std::chrono::duration<double>(candidate_time).count());
+    }
   }
-  return "th";
 };
+}  // namespace detail
 
-template <class TArg>
-inline std::string format_test_parameter([[maybe_unused]] const TArg& arg,
-                                         const int counter) {
-  return std::to_string(counter) + get_ordinal_suffix(counter) + " parameter";
+/// runs `reference` and `candidate` on every input piped into it and expects
+/// equal results (by `compare`), e.g.
+/// "sort"_test = differential(reference_sort, fast_sort) | inputs;
+template <class TReference, class TCandidate, class TCompare = std::equal_to<>>
+[[nodiscard]] constexpr auto differential(
+    const TReference& reference, const TCandidate& candidate,
+    const TCompare& compare = {},
+    const reflection::source_location& location =
+        reflection::source_location::current()) {
+  return detail::differential_<TReference, TCandidate, TCompare>{
+      reference, candidate, compare, location};
 }
 
-template <class F>
-  requires(std::integral<F> || std::floating_point<F>) &&
-          (!std::same_as<F, bool>)
-inline std::string
-    format_test_parameter(const F& arg, [[maybe_unused]] const int counter) {
-  std::ostringstream oss;
-  oss << arg;
-  return oss.str();
-}
+/// an operation issued by a load test (see rate)
+class load_ctx {
+ public:
+  load_ctx(const std::size_t op, const std::size_t worker)
+      : op_{op}, worker_{worker} {}
 
-inline std::string format_test_parameter(const bool& arg,
-                                         [[maybe_unused]] const int counter) {
-  return arg ? "true" : "false";
+  /// ordinal of the operation in the schedule
+  [[nodiscard]] auto op() const -> std::size_t { return op_; }
+  /// index of the thread issuing the operation
+  [[nodiscard]] auto worker() const -> std::size_t { return worker_; }
+  /// counts the operation as an error (but still measures its latency)
+  auto error() -> void { error_ = true; }
+  [[nodiscard]] auto failed() const -> bool { return error_; }
+
+ private:
+  std::size_t op_{};
+  std::size_t worker_{};
+  bool error_{};
+};
+
+namespace detail {
+/// open loop load: operations are issued on a fixed schedule regardless of
+/// how long the previous ones take, with latency measured from the intended
+/// start so that queueing behind slow operations is not hidden. At most
+/// `threads` operations are in flight; operations which could only be issued
+/// late because all threads were busy are counted (the `late` gauge).
+/// Calls to the runner (e.g. expect) from the threads are made one at a time.
+struct rate_ {
+  static constexpr auto late_after = std::chrono::milliseconds{1};
+
+  double ops_per_second{};
+  std::chrono::nanoseconds duration{};
+  std::size_t threads{};
+
+  template <class F>
+  auto operator()(const F& f) const -> void {
+    using clock = std::chrono::steady_clock;
+    struct worker_t {
+      std::vector<clock::duration> latencies{};
+      std::vector<std::size_t> timeline{};  // completed per second
+      std::size_t errors{};
+      std::size_t late{};
+#if defined(__cpp_exceptions)
+      std::exception_ptr exception{};
+#endif
+    };
+    const auto workers_count =
+        threads ? threads
+                : std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    const auto ops = static_cast<std::size_t>(
+        ops_per_second * std::chrono::duration<double>(duration).count());
+    const auto seconds = static_cast<std::size_t>(
+        std::chrono::ceil<std::chrono::seconds>(duration).count());
+    auto workers = std::vector<worker_t>(workers_count);
+    auto next = std::atomic<std::size_t>{};
+    const auto rng_path = rng_::path;
+    const auto run = trace::running();
+    const auto start = clock::now();
+    const auto schedule = [&](const std::size_t op) {
+      return start + std::chrono::duration_cast<clock::duration>(
+                         std::chrono::duration<double>(
+                             static_cast<double>(op) / ops_per_second));
+    };
+    constexpr auto wakeup = std::chrono::microseconds{100};
+    const auto issue = [&](const std::size_t index) {
+      auto& worker = workers[index];
+      rng_::path = rng_path;
+      trace::adopt(run);
+      if (index) {
+        notify<F>(events::load_worker{});
+      }
+      worker.latencies.reserve(ops / workers_count + 1);
+      worker.timeline.resize(seconds + 1);
+      for (auto op = next++; op < ops; op = next++) {
+        const auto intended = schedule(op);
+        std::this_thread::sleep_until(intended - wakeup);
+        while (clock::now() < intended) {  // the wakeup is not that precise
+          std::this_thread::yield();
+        }
+        worker.late += clock::now() - intended > late_after;
+        auto ctx = load_ctx{op, index};
+#if defined(__cpp_exceptions)
+        try {
+          f(ctx);
+        } catch (...) {
+          if (not worker.exception) {
+            worker.exception = std::current_exception();
+          }
+          ctx.error();
+        }
+#else
+        f(ctx);
+#endif
+        const auto now = clock::now();
+        worker.latencies.push_back(now - intended);
+        worker.errors += ctx.failed();
+        ++worker.timeline[std::min(
+            static_cast<std::size_t>((now - start) / std::chrono::seconds{1}),
+            seconds)];
+      }
+    };
+    notify<F>(events::load_begin{});
+    auto pool = std::vector<std::thread>{};
+    for (auto index = 1u; index < workers_count; ++index) {
+      pool.emplace_back(issue, index);
+    }
+    issue(0);
+    for (auto& thread : pool) {
+      thread.join();
+    }
+    notify<F>(events::load_end{});
+    const auto elapsed = clock::now() - start;
+
+    auto latencies = std::vector<clock::duration>{};
+    latencies.reserve(ops);
+    auto timeline = std::vector<std::size_t>(seconds + 1);
+    auto errors = std::size_t{};
+    auto late = std::size_t{};
+    for (auto& worker : workers) {
+      latencies.insert(latencies.end(), worker.latencies.cbegin(),
+                       worker.latencies.cend());
+      for (auto second = 0u; second < timeline.size(); ++second) {
+        timeline[second] += worker.timeline[second];
+      }
+      errors += worker.errors;
+      late += worker.late;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    const auto us = [](const clock::duration latency) {
+      return std::chrono::duration<double, std::micro>(latency).count();
+    };
+    if (not latencies.empty()) {
+      for (const auto& [name, quantile] :
+           {std::pair{"p50_us", 0.5}, std::pair{"p90_us", 0.9},
+            std::pair{"p99_us", 0.99}, std::pair{"p999_us", 0.999}}) {
+        const auto rank = static_cast<std::size_t>(
+            quantile * static_cast<double>(latencies.size() - 1));
+        metrics::get(name, metrics::kind::gauge).set(us(latencies[rank]));
+      }
+      metrics::get("max_us", metrics::kind::gauge).set(us(latencies.back()));
+    }
+    metrics::get("ops_per_s", metrics::kind::gauge)
+        .set(static_cast<double>(latencies.size()) /
+             std::chrono::duration<double>(elapsed).count());
+    metrics::get("errors", metrics::kind::gauge)
+        .set(static_cast<double>(errors));
+    metrics::get("late", metrics::kind::gauge).set(static_cast<double>(late));
+    if (not timeline.back()) {
+      timeline.pop_back();
+    }
+    auto out = std::string{"throughput (ops per second):"};
+    for (const auto completed : timeline) {
+      out += ' ' + std::to_string(completed);
+    }
+    if (late) {
+      out += "\n" + std::to_string(late) + " of " + std::to_string(ops) +
+             " operations issued late, all " + std::to_string(workers_count) +
+             " threads were busy";
+    }
+    on<F>(events::log{out + '\n'});
+#if defined(__cpp_exceptions)
+    for (const auto& worker : workers) {
+      if (worker.exception) {
+        std::rethrow_exception(worker.exception);
+      }
+    }
+#endif
+  }
+
+ private:
+  /// sends `event` to runners which handle it
+  template <class F, class TEvent>
+  static auto notify(const TEvent& event) -> void {
+    if constexpr (requires {
+                    ut::cfg<typename type_traits::identity<override, F>::type>
+                        .on(event);
+                  }) {
+      on<F>(event);
+    }
+  }
+};
+}  // namespace detail
+
+/// an open loop load of `ops_per_second` operations for `duration`, spread
+/// over `threads` threads (the number of cores by default), e.g.
+/// "get"_load = rate(50'000, 30s) | [&](load_ctx&) { client.get("/"); };
+/// latency percentiles, the achieved throughput, the number of errors and of
+/// late operations (at most `threads` are in flight) are reported as gauges,
+/// completions per second as a log line
+template <class TRep, class TPeriod>
+[[nodiscard]] constexpr auto rate(
+    const double ops_per_second,
+    const std::chrono::duration<TRep, TPeriod> duration,
+    const std::size_t threads = 0) {
+  return detail::rate_{
+      .ops_per_second = ops_per_second,
+      .duration =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(duration),
+      .threads = threads};
 }
 
 namespace operators {
-[[nodiscard]] constexpr auto operator==(std::string_view lhs,
-                                        std::string_view rhs) {
+[[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto operator==(
+    std::string_view lhs, std::string_view rhs) {
   return detail::eq_{lhs, rhs};
 }
 
-[[nodiscard]] constexpr auto operator!=(std::string_view lhs,
-                                        std::string_view rhs) {
+[[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto operator!=(
+    std::string_view lhs, std::string_view rhs) {
   return detail::neq_{lhs, rhs};
 }
 
 template <std::ranges::range T>
-[[nodiscard]] constexpr auto operator==(T&& lhs, T&& rhs) {
+[[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto operator==(T&& lhs,
+                                                               T&& rhs) {
   return detail::eq_{static_cast<T&&>(lhs), static_cast<T&&>(rhs)};
 }
 
 template <std::ranges::range T>
-[[nodiscard]] constexpr auto operator!=(T&& lhs, T&& rhs) {
+[[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto operator!=(T&& lhs,
+                                                               T&& rhs) {
   return detail::neq_{static_cast<T&&>(lhs), static_cast<T&&>(rhs)};
 }
 
 template <class TLhs, class TRhs>
   requires type_traits::is_op<TLhs> || type_traits::is_op<TRhs>
-[[nodiscard]] constexpr auto operator==(const TLhs& lhs, const TRhs& rhs) {
+[[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto operator==(
+    const TLhs& lhs, const TRhs& rhs) {
   return detail::eq_{lhs, rhs};
 }
 
 template <class TLhs, class TRhs>
   requires type_traits::is_op<TLhs> || type_traits::is_op<TRhs>
-[[nodiscard]] constexpr auto operator!=(const TLhs& lhs, const TRhs& rhs) {
+[[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto operator!=(
+    const TLhs& lhs, const TRhs& rhs) {
   return detail::neq_{lhs, rhs};
 }
 
 template <class TLhs, class TRhs>
   requires type_traits::is_op<TLhs> || type_traits::is_op<TRhs>
-[[nodiscard]] constexpr auto operator>(const TLhs& lhs, const TRhs& rhs) {
+[[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto operator>(const TLhs& lhs,
+                                                              const TRhs& rhs) {
   return detail::gt_{lhs, rhs};
 }
 
 template <class TLhs, class TRhs>
   requires type_traits::is_op<TLhs> || type_traits::is_op<TRhs>
-[[nodiscard]] constexpr auto operator>=(const TLhs& lhs, const TRhs& rhs) {
+[[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto operator>=(
+    const TLhs& lhs, const TRhs& rhs) {
   return detail::ge_{lhs, rhs};
 }
 
 template <class TLhs, class TRhs>
   requires type_traits::is_op<TLhs> || type_traits::is_op<TRhs>
-[[nodiscard]] constexpr auto operator<(const TLhs& lhs, const TRhs& rhs) {
+[[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto operator<(const TLhs& lhs,
+                                                              const TRhs& rhs) {
   return detail::lt_{lhs, rhs};
 }
 
 template <class TLhs, class TRhs>
   requires type_traits::is_op<TLhs> || type_traits::is_op<TRhs>
-[[nodiscard]] constexpr auto operator<=(const TLhs& lhs, const TRhs& rhs) {
+[[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto operator<=(
+    const TLhs& lhs, const TRhs& rhs) {
   return detail::le_{lhs, rhs};
 }
 
@@ -2735,6 +7234,9 @@ template <class Test>
   for (const auto& name : tag.name) {
     test.tag.push_back(name);
   }
+  if (tag.max_stack) {
+    test.max_stack = tag.max_stack;
+  }
   return test;
 }
 
@@ -2748,7 +7250,7 @@ template <class Test>
   for (const auto& name : rhs.name) {
     tag.push_back(name);
   }
-  return detail::tag{tag};
+  return detail::tag{tag, rhs.max_stack ? rhs.max_stack : lhs.max_stack};
 }
 
 template <class F, class T>
@@ -2769,6 +7271,62 @@ template <class F, class T>
   };
 }
 
+template <class F>
+[[nodiscard]] auto operator|(const F& f, const detail::rows_& rows) {
+  return [f, rows](std::string_view type, std::string_view name) {
+    for (const auto& arg : rows) {
+      const auto run = [f, path = rows.path(),
+                        location = rows.location()](const row& r) {
+        if constexpr (std::invocable<F, const row&>) {
+          f(r);
+        } else {
+          [&]<class... TArgs>(type_traits::list<TArgs...>) {
+            [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+              const auto fields = std::tuple{
+                  r.template get<std::remove_cvref_t<TArgs>>(Is)...};
+              if ((std::get<Is>(fields) and ...)) {
+                f(*std::get<Is>(fields)...);
+              } else {
+                void(detail::on<F>(events::assertion<bool>{
+                    .expr = false, .location = location}));
+                detail::on<F>(events::log<std::string>{
+                    " " + path + ':' + std::to_string(r.line()) +
+                    ": cannot convert the fields to the test arguments\n"});
+              }
+            }(std::index_sequence_for<TArgs...>{});
+          }(typename type_traits::function_traits<F>::args{});
+        }
+      };
+      detail::on<F>(events::test<decltype(run), row>{
+          .type = type,
+          .name = std::string{name} + " (line " + std::to_string(arg.line()) + ")",
+          .tag = {},
+          .location = {},
+          .arg = arg,
+          .run = run});
+    }
+  };
+}
+
+template <class... Ts, class T>
+  requires std::ranges::range<T>
+[[nodiscard]] constexpr auto operator|(const detail::differential_<Ts...>& f,
+                                       const T& inputs) {
+  return [f, inputs] { f(inputs); };
+}
+
+template <class... Ts>
+[[nodiscard]] auto operator|(const detail::differential_<Ts...>& f,
+                             const detail::rows_& rows) {
+  return [f, rows] { f(rows); };
+}
+
+template <class F>
+  requires std::invocable<const F&, load_ctx&>
+[[nodiscard]] constexpr auto operator|(const detail::rate_& load, const F& f) {
+  return [load, f] { load(f); };
+}
+
 template <class F, template <class...> class T, class... Ts>
   requires(!std::ranges::range<T<Ts...>>)
 [[nodiscard]] constexpr auto operator|(const F& f, const T<Ts...>& t) {
@@ -3023,9 +7581,9 @@ constexpr auto operator not(const T& t) {
 template <class TExpr>
   requires type_traits::is_op<TExpr> ||
            concepts::explicitly_convertible_to<TExpr, bool>
-constexpr auto expect(const TExpr& expr,
-                      const reflection::source_location& sl =
-                          reflection::source_location::current()) {
+BOOST_UT_ALWAYS_INLINE constexpr auto expect(
+    const TExpr& expr, const reflection::source_location& sl =
+                           reflection::source_location::current()) {
   return detail::expect_<TExpr>{detail::on<TExpr>(
       events::assertion<TExpr>{.expr = expr, .location = sl})};
 }
@@ -3056,6 +7614,38 @@ template <class TExpr>
 }
 #endif
 
+using notifier = detail::notifier;
+
+/// whether `pred` holds within `timeout`, checked with exponential backoff
+/// (1us up to 10ms) or as soon as `wakeup` is notified
+template <class TPred, class TRep, class TPeriod>
+[[nodiscard]] auto eventually(
+    const TPred& pred, const std::chrono::duration<TRep, TPeriod>& timeout) {
+  return detail::eventually_{
+      pred, std::chrono::ceil<std::chrono::steady_clock::duration>(timeout)};
+}
+
+template <class TPred, class TRep, class TPeriod>
+[[nodiscard]] auto eventually(
+    const TPred& pred, const std::chrono::duration<TRep, TPeriod>& timeout,
+    notifier& wakeup) {
+  return detail::eventually_{
+      pred, std::chrono::ceil<std::chrono::steady_clock::duration>(timeout),
+      &wakeup};
+}
+
+/// whether `expr` does not allocate on the heap (on the current thread)
+template <class TExpr>
+[[nodiscard]] auto no_alloc(const TExpr& expr) {
+  return detail::allocs_{expr, 0};
+}
+
+/// whether `expr` allocates at most `n` times (on the current thread)
+template <class TExpr>
+[[nodiscard]] auto max_allocs(const std::size_t n, const TExpr& expr) {
+  return detail::allocs_{expr, n};
+}
+
 #if __has_include(<unistd.h>) and __has_include(<sys/wait.h>)
 template <class TExpr>
 [[nodiscard]] constexpr auto aborts(const TExpr& expr) {
@@ -3105,6 +7695,67 @@ struct suite {
 };
 
 [[maybe_unused]] inline auto log = detail::log{};
+
+inline auto metric(std::string_view name, const double value) -> void {
+  detail::metrics::get(name, detail::metrics::kind::metric).add(value);
+}
+[[nodiscard]] inline auto counter(std::string_view name) -> detail::counter_ {
+  return detail::counter_{
+      detail::metrics::get(name, detail::metrics::kind::counter)};
+}
+inline auto gauge(std::string_view name, const double value) -> void {
+  detail::metrics::get(name, detail::metrics::kind::gauge).set(value);
+}
+/// random numbers of the running test, the same for every call with the same
+/// `stream` (e.g. auto g = rng(); std::uniform_int_distribution{1, 6}(g)).
+/// The test is known on the threads running it (including parallel children
+/// and load workers), threads started by the test get a generator from it.
+[[nodiscard]] inline auto rng(const std::uint64_t stream = 0) -> detail::rng_ {
+  detail::rng_::used = true;
+  return detail::rng_{detail::rng_::mix(
+      detail::rng_::nested(detail::rng_::path, {}) ^
+      detail::rng_::mix(detail::rng_::seed() + stream))};
+}
+
+/// all combinations of the values of the given ranges, computed on access
+template <std::ranges::range... TDims>
+[[nodiscard]] auto product(const TDims&... dims) {
+  return detail::product_<TDims...>{dims...};
+}
+/// combinations containing every combination of the values of any `T` of the
+/// given dimensions, either ranges of values (std::vector<std::tuple<...>>)
+/// or std::tuple<Ts...> of types (std::tuple<std::tuple<...>...>)
+template <std::size_t T, class... TDims>
+[[nodiscard]] constexpr auto t_wise(const TDims&... dims) {
+  return detail::t_wise<T>(dims...);
+}
+template <class... TDims>
+[[nodiscard]] constexpr auto pairwise(const TDims&... dims) {
+  return detail::t_wise<2>(dims...);
+}
+/// `budget` elements of `range`, chosen uniformly at random and kept in order
+/// (seed 0 uses the run seed, see rng)
+template <std::ranges::range TRange>
+[[nodiscard]] auto sample(const TRange& range, const std::size_t budget,
+                          std::uint64_t seed = 0)
+    -> std::vector<std::ranges::range_value_t<TRange>> {
+  if (not seed) {
+    detail::rng_::used = true;
+    seed = detail::rng_::seed();
+  }
+  auto gen = detail::rng_{detail::rng_::mix(seed)};
+  auto selected = std::vector<std::ranges::range_value_t<TRange>>{};
+  auto left = static_cast<std::size_t>(std::ranges::distance(range));
+  for (auto it = std::ranges::begin(range); selected.size() < budget and left;
+       ++it, --left) {
+    // selects with probability (budget - selected) / left
+    if ((gen() >> 11U) % left < budget - selected.size()) {
+      selected.push_back(*it);
+    }
+  }
+  return selected;
+}
+
 [[maybe_unused]] inline auto that = detail::that_{};
 [[maybe_unused]] constexpr auto test = [](const auto name) {
   return detail::test{"test", name};
@@ -3114,50 +7765,64 @@ struct suite {
   return detail::tag{{name}};
 };
 [[maybe_unused]] inline auto skip = tag("skip");
+/// fails the (top-level) test if it uses more than `bytes` of stack, which is
+/// measured by running it on a painted stack
+[[nodiscard]] inline auto max_stack(const std::size_t bytes) -> detail::tag {
+  return detail::tag{.name = {}, .max_stack = bytes};
+}
+/// child tests declared in its scope run concurrently (on worker threads),
+/// joined at the end of the scope and reported in declaration order
+using parallel_children = detail::parallel_children_<>;
 template <class T = void>
 [[maybe_unused]] constexpr auto type = detail::type_<T>();
 
 template <class TLhs, class TRhs>
   requires type_traits::is_stream_insertable_v<TLhs> &&
            type_traits::is_stream_insertable_v<TRhs>
-[[nodiscard]] constexpr auto eq(const TLhs& lhs, const TRhs& rhs) {
+[[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto eq(const TLhs& lhs,
+                                                       const TRhs& rhs) {
   return detail::eq_{lhs, rhs};
 }
 template <class TLhs, class TRhs, class TEpsilon>
   requires type_traits::is_stream_insertable_v<TLhs> &&
            type_traits::is_stream_insertable_v<TRhs>
-[[nodiscard]] constexpr auto approx(const TLhs& lhs, const TRhs& rhs,
-                                    const TEpsilon& epsilon) {
+[[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto approx(
+    const TLhs& lhs, const TRhs& rhs, const TEpsilon& epsilon) {
   return detail::approx_{lhs, rhs, epsilon};
 }
 template <class TLhs, class TRhs>
   requires type_traits::is_stream_insertable_v<TLhs> &&
            type_traits::is_stream_insertable_v<TRhs>
-[[nodiscard]] constexpr auto neq(const TLhs& lhs, const TRhs& rhs) {
+[[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto neq(const TLhs& lhs,
+                                                        const TRhs& rhs) {
   return detail::neq_{lhs, rhs};
 }
 template <class TLhs, class TRhs>
   requires type_traits::is_stream_insertable_v<TLhs> &&
            type_traits::is_stream_insertable_v<TRhs>
-[[nodiscard]] constexpr auto gt(const TLhs& lhs, const TRhs& rhs) {
+[[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto gt(const TLhs& lhs,
+                                                       const TRhs& rhs) {
   return detail::gt_{lhs, rhs};
 }
 template <class TLhs, class TRhs>
   requires type_traits::is_stream_insertable_v<TLhs> &&
            type_traits::is_stream_insertable_v<TRhs>
-[[nodiscard]] constexpr auto ge(const TLhs& lhs, const TRhs& rhs) {
+[[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto ge(const TLhs& lhs,
+                                                       const TRhs& rhs) {
   return detail::ge_{lhs, rhs};
 }
 template <class TLhs, class TRhs>
   requires type_traits::is_stream_insertable_v<TLhs> &&
            type_traits::is_stream_insertable_v<TRhs>
-[[nodiscard]] constexpr auto lt(const TLhs& lhs, const TRhs& rhs) {
+[[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto lt(const TLhs& lhs,
+                                                       const TRhs& rhs) {
   return detail::lt_{lhs, rhs};
 }
 template <class TLhs, class TRhs>
   requires type_traits::is_stream_insertable_v<TLhs> &&
            type_traits::is_stream_insertable_v<TRhs>
-[[nodiscard]] constexpr auto le(const TLhs& lhs, const TRhs& rhs) {
+[[nodiscard]] BOOST_UT_ALWAYS_INLINE constexpr auto le(const TLhs& lhs,
+                                                       const TRhs& rhs) {
   return detail::le_{lhs, rhs};
 }
 
@@ -3320,6 +7985,7 @@ namespace spec {
 }  // namespace spec
 
 using literals::operator""_test;
+using literals::operator""_load;
 
 using literals::operator""_b;
 using literals::operator""_i;
@@ -3370,6 +8036,68 @@ __attribute__((constructor(101))) inline void cmd_line_args(
 // For MSVC, largc/largv are initialized with __argc/__argv
 #endif
 
+#if defined(BOOST_UT_ALLOC_HOOKS) and not defined(BOOST_UT_CXX_MODULES)
+// Replaces the global operator new (and so its array and nothrow variants) in
+// the one translation unit defining BOOST_UT_ALLOC_HOOKS.
+void* operator new(std::size_t size) {
+  ::boost::ut::detail::allocations::on_allocation();
+  if (auto* ptr = std::malloc(size ? size : 1)) {
+    return ptr;
+  }
+#if defined(__cpp_exceptions)
+  throw std::bad_alloc{};
+#else
+  std::abort();
+#endif
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  ::boost::ut::detail::allocations::on_allocation();
+  const auto align = static_cast<std::size_t>(alignment);
+#if defined(_MSC_VER)
+  auto* ptr = _aligned_malloc(size ? size : 1, align);
+#else
+  auto* ptr = std::aligned_alloc(align, size ? (size + align - 1) / align * align
+                                              : align);
+#endif
+  if (ptr) {
+    return ptr;
+  }
+#if defined(__cpp_exceptions)
+  throw std::bad_alloc{};
+#else
+  std::abort();
+#endif
+}
+
+#if defined(__GNUC__) and not defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+#if defined(_MSC_VER)
+  _aligned_free(ptr);
+#else
+  std::free(ptr);
+#endif
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t alignment) noexcept {
+  operator delete(ptr, alignment);
+}
+#if defined(__GNUC__) and not defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace boost::inline ext::ut::inline v2_3_1::detail {
+[[maybe_unused]] inline const bool alloc_hooks = allocations::hooked = true;
+}  // namespace boost::inline ext::ut::inline v2_3_1::detail
+#endif
+
 #if defined(_MSC_VER)
 #pragma pop_macro("min")
 #pragma pop_macro("max")
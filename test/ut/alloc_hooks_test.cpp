@@ -0,0 +1,91 @@
+//
+// Copyright (c) 2019-2020 Kris Jusiak (kris at jusiak dot net)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// no_alloc/max_allocs need the allocation hooks, which replace the global
+// operator new of the whole executable, hence a test executable of their own.
+#define BOOST_UT_ALLOC_HOOKS
+#include "boost/ut.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace ut = boost::ut;
+
+namespace {
+auto test_assert = [](const bool result,
+                      const ut::reflection::source_location& sl =
+                          ut::reflection::source_location::current()) {
+  if (not result) {
+    std::cerr << sl.file_name() << ':' << sl.line() << ":FAILED" << std::endl;
+    std::abort();
+  }
+};
+}  // namespace
+
+struct fake_cfg {
+  struct assertion_call {
+    std::string expr{};
+    bool result{};
+  };
+
+  template <class... Ts>
+  auto on(ut::events::test<Ts...> test) -> void {
+    test();
+  }
+  template <class... Ts>
+  auto on(ut::events::skip<Ts...>) -> void {}
+  template <class TExpr>
+  auto on(const ut::events::assertion<TExpr>& assertion) -> bool {
+    ut::printer printer{{.none = "", .pass = "", .fail = ""}};
+    printer << assertion.expr;
+    assertion_calls.push_back(
+        {.expr = printer.str(), .result = assertion.expr});
+    return assertion.expr;
+  }
+  auto on(ut::events::fatal_assertion) -> void {}
+  template <class TMsg>
+  auto on(ut::events::log<TMsg>) -> void {}
+
+  std::vector<assertion_call> assertion_calls{};
+};
+
+template <class... Ts>
+static auto ut::cfg<ut::override, Ts...> = fake_cfg{};
+
+int main() {
+  using namespace ut;
+  auto& test_cfg = ut::cfg<ut::override>;
+
+  "allocations"_test = [] {
+    auto values = std::vector<int>(4);
+    expect(no_alloc([&] { values[0] = 42; }));
+    expect(no_alloc([&] { values.reserve(64); }));
+    expect(max_allocs(2, [&] {
+      values.reserve(128);
+      expect(max_allocs(1, [&] { values.reserve(256); }));
+    }));
+    expect(max_allocs(1, [&] {
+      values.reserve(512);
+      values.reserve(1024);
+    }));
+  };
+
+  test_assert(5 == std::size(test_cfg.assertion_calls));
+  test_assert(test_cfg.assertion_calls[0].result);
+  test_assert("no_alloc" == test_cfg.assertion_calls[0].expr);
+  test_assert(not test_cfg.assertion_calls[1].result);
+  test_assert(test_cfg.assertion_calls[1].expr.starts_with(
+      "no_alloc: 1 allocations"));
+  test_assert(test_cfg.assertion_calls[2].result);
+  test_assert(test_cfg.assertion_calls[3].result);
+  test_assert("max_allocs(2)" == test_cfg.assertion_calls[3].expr);
+  test_assert(not test_cfg.assertion_calls[4].result);
+  test_assert(test_cfg.assertion_calls[4].expr.starts_with(
+      "max_allocs(1): 2 allocations"));
+}
@@ -0,0 +1,112 @@
+#include <boost/ut.hpp>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <set>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+/// whether all combinations of values of any two dimensions are in `rows`
+template <class TRows>
+auto covers_pairs(const TRows& rows, const std::vector<std::size_t>& sizes) {
+  for (auto a = 0u; a < sizes.size(); ++a) {
+    for (auto b = a + 1; b < sizes.size(); ++b) {
+      auto pairs = std::set<std::pair<std::size_t, std::size_t>>{};
+      for (const auto& row : rows) {
+        pairs.emplace(row[a], row[b]);
+      }
+      if (pairs.size() != sizes[a] * sizes[b]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+}  // namespace
+
+int main() {
+  using namespace boost::ut;
+
+  "covering array"_test = [] {
+    const auto sizes = std::vector<std::size_t>(6, 10);
+    const auto rows = detail::covering_array(sizes, 2);
+    expect(covers_pairs(rows, sizes));
+    expect(rows.size() < 200_ul) << "1'000'000 combinations";
+
+    const auto mixed = std::vector<std::size_t>{3, 2, 4, 2};
+    expect(covers_pairs(detail::covering_array(mixed, 2), mixed));
+    expect(48_ul == detail::covering_array(mixed, 4).size());
+    expect(48_ul == detail::covering_array(mixed, 5).size());
+    expect(detail::covering_array({3, 0, 2}, 2).empty());
+  };
+
+  "t-wise"_test = [] {
+    const auto triples = t_wise<3>(std::vector{1, 2, 3}, std::vector{4, 5},
+                                   std::vector{6, 7}, std::vector{8, 9});
+    for (const auto& [a, b, c] :
+         std::vector<std::array<int, 3>>{{0, 1, 2}, {1, 2, 3}, {0, 2, 3}}) {
+      auto combinations = std::set<std::vector<int>>{};
+      for (const auto& row : triples) {
+        const auto values = std::apply(
+            [](auto... v) { return std::array{v...}; }, row);
+        combinations.insert({values[static_cast<std::size_t>(a)],
+                             values[static_cast<std::size_t>(b)],
+                             values[static_cast<std::size_t>(c)]});
+      }
+      expect(eq(a ? std::size_t{8} : std::size_t{12}, combinations.size()));
+    }
+  };
+
+  "pairwise values"_test =
+      [](const std::tuple<int, std::string, bool>& arg) {
+        expect(std::get<0>(arg) > 0_i);
+        expect(not std::get<1>(arg).empty());
+      } |
+      pairwise(std::vector{1, 2, 3}, std::vector<std::string>{"a", "b"},
+               std::vector{true, false});
+
+  "pairwise types"_test = []<class T>() {
+    using first = std::tuple_element_t<0, T>;
+    using second = std::tuple_element_t<1, T>;
+    expect(std::is_arithmetic_v<first> and std::is_arithmetic_v<second>);
+  } | pairwise(std::tuple<int, float, double>{}, std::tuple<char, short>{},
+               std::tuple<long, unsigned>{});
+
+  "pairwise types size"_test = [] {
+    using rows = decltype(pairwise(std::tuple<int, float, double>{},
+                                   std::tuple<char, short>{},
+                                   std::tuple<long, unsigned>{}));
+    expect(constant<6 == std::tuple_size_v<rows>>);
+    expect(type<std::tuple_element_t<0, rows>> ==
+           type<std::tuple<int, char, long>>);
+  };
+
+  "product"_test = [] {
+    const auto all = product(std::vector{1, 2}, std::vector{'a', 'b', 'c'});
+    expect(6_ul == all.size());
+    expect(std::tuple{1, 'a'} == all[0]);
+    expect(std::tuple{1, 'c'} == all[2]);
+    expect(std::tuple{2, 'a'} == all[3]);
+    expect(6_l == std::ranges::distance(all));
+  };
+
+  "sample"_test = [] {
+    const auto dim = std::vector{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    const auto all = product(dim, dim, dim, dim, dim, dim);
+    const auto some = sample(all, 100, 42);
+    expect(100_ul == some.size());
+    expect(std::is_sorted(some.cbegin(), some.cend()));
+    expect(std::adjacent_find(some.cbegin(), some.cend()) == some.cend());
+    expect(some == sample(all, 100, 42));
+    expect(some != sample(all, 100, 43));
+    expect(6_ul == sample(std::vector{1, 2, 3, 4, 5, 6}, 10, 1).size());
+  };
+
+  "sampled"_test = [](const auto& arg) {
+    expect(std::get<0>(arg) < 10_i);
+  } | sample(product(std::vector{1, 2, 3}, std::vector{4, 5, 6}), 4);
+}
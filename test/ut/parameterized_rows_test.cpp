@@ -0,0 +1,119 @@
+#include <boost/ut.hpp>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+auto write(const std::string& path, std::string_view content) {
+  std::ofstream{path, std::ios::binary} << content;
+  return path;
+}
+}  // namespace
+
+int main() {
+  using namespace boost::ut;
+
+  const auto csv = write("parameterized_rows_test.csv",
+                         "# a, b, sum\n"
+                         "1,2,3\n"
+                         "\n"
+                         "-4,10,6\r\n"
+                         "\"7\",0,7\n"
+                         "2.5,0.5,3");
+  const auto jsonl = write("parameterized_rows_test.jsonl",
+                           R"({"name": "a,b", "size": 3, "tags": [1, 2]})"
+                           "\n"
+                           R"(["", 0, {}])"
+                           "\n");
+
+  "csv rows"_test = [&] {
+    auto lines = std::vector<std::size_t>{};
+    for (const auto& r : rows_from(csv)) {
+      lines.push_back(r.line());
+      expect(3_ul == r.size());
+    }
+    expect(lines == std::vector<std::size_t>{2, 4, 5, 6});
+
+    const auto r = *rows_from(csv).begin();
+    expect(r[0] == "1" and r[2] == "3");
+    expect(2_i == *r.get<int>(1));
+    expect(not r.get<int>(3).has_value());
+    expect(not row{1, {"x"}}.get<int>(0).has_value());
+    expect(that % true == *row{1, {"true"}}.get<bool>(0));
+    expect(std::string{"x"} == *row{1, {"x"}}.get<std::string>(0));
+  };
+
+  "json lines rows"_test = [&] {
+    const auto rows = rows_from(jsonl);
+    auto it = rows.begin();
+    const auto first = *it;
+    expect(first[0] == "a,b" and first[1] == "3" and first[2] == "[1, 2]");
+    const auto second = *++it;
+    expect(2_ul == second.line());
+    expect(second[0] == "" and second[1] == "0" and second[2] == "{}");
+    expect(++it == rows.end());
+  };
+
+  "shards"_test = [&] {
+    const auto rows = rows_from(csv);
+    auto lines = std::vector<std::size_t>{};
+    for (auto shard = 0u; shard < 3; ++shard) {
+      for (const auto& r : rows.shard(shard, 3)) {
+        lines.push_back(r.line());
+      }
+    }
+    expect(lines == std::vector<std::size_t>{2, 4, 5, 6});
+
+    const auto lines_of = [](const auto& shard) {
+      auto of = std::vector<std::size_t>{};
+      for (const auto& r : shard) {
+        of.push_back(r.line());
+      }
+      return of;
+    };
+    const auto half = rows.shard(1, 2);
+    lines.clear();
+    for (auto shard = 0u; shard < 2; ++shard) {
+      for (const auto line : lines_of(half.shard(shard, 2))) {
+        lines.push_back(line);
+      }
+    }
+    expect(not lines.empty() and lines == lines_of(half));
+  };
+
+  "header"_test = [&] {
+    const auto rows = rows_from(csv).skip_header();
+    auto lines = std::vector<std::size_t>{};
+    for (auto shard = 0u; shard < 2; ++shard) {
+      for (const auto& r : rows.shard(shard, 2)) {
+        lines.push_back(r.line());
+      }
+    }
+    expect(lines == std::vector<std::size_t>{4, 5, 6});
+    const auto missing = rows_from("parameterized_rows_test.missing");
+    expect(missing.skip_header().begin() == missing.end());
+  };
+
+  "missing file"_test = [] {
+    const auto rows = rows_from("parameterized_rows_test.missing");
+    expect(rows.begin() == rows.end());
+  };
+
+  "sum"_test = [](double a, double b, double sum) {
+    expect(a + b == sum);
+  } | rows_from(csv);
+
+  "sum of row"_test = [](const row& r) {
+    expect(*r.get<int>(0) + *r.get<int>(1) == *r.get<int>(2));
+  } | rows_from(csv).shard(0, 2);
+
+  "string views"_test = [](std::string_view name, std::size_t size) {
+    expect(eq(name.size(), size) or name.empty());
+  } | rows_from(jsonl);
+
+  std::remove(csv.c_str());
+  std::remove(jsonl.c_str());
+}
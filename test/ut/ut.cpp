@@ -5,6 +5,8 @@
 // (See accompanying file LICENSE_1_0.txt or copy at
 // http://www.boost.org/LICENSE_1_0.txt)
 //
+// tests the tooling of whole runs as well, see BOOST_UT_RUN_TOOLS
+#define BOOST_UT_RUN_TOOLS
 #include "boost/ut.hpp"
 
 #include <algorithm>
@@ -12,12 +14,19 @@
 #include <array>
 #include <complex>
 #include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <numeric>
+#include <random>
+#include <set>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -311,6 +320,95 @@ struct test_summary_runner : ut::runner<test_summary_reporter> {
   using runner::reporter_;
 };
 
+struct test_metric_reporter : ut::reporter<ut::printer> {
+  using reporter::on;
+
+  auto on(ut::events::test_begin) -> void {}
+  auto on(ut::events::test_end) -> void {}
+  auto on(ut::events::summary) -> void {}
+  auto on(ut::events::metric metric) -> void {
+    metrics.push_back({std::string{metric.name}, std::string{metric.kind},
+                       metric.value});
+  }
+
+  struct metric_call {
+    std::string name{};
+    std::string kind{};
+    double value{};
+  };
+  std::vector<metric_call> metrics{};
+};
+
+struct test_metric_runner : ut::runner<test_metric_reporter> {
+  using runner::reporter_;
+};
+
+template <char Id>
+struct test_fanout_reporter {
+  auto on(ut::events::test_begin) -> void { *trace += Id; }
+  auto on(ut::events::test_end) -> void { *trace += Id; }
+  auto on(ut::events::summary) -> void { *trace += Id; }
+
+  std::string* trace{};
+};
+
+struct test_quiet_reporter : test_reporter {
+  using test_reporter::on;
+  auto on(ut::events::summary) -> void {}
+};
+
+struct test_fanout_runner
+    : ut::runner<ut::reporters<test_quiet_reporter, test_fanout_reporter<'a'>,
+                               test_fanout_reporter<'b'>>> {
+  using runner::reporter_;
+};
+
+struct test_failures_reporter {
+  using subscribed_events =
+      ut::type_traits::list<ut::events::assertion_fail<>, ut::events::log<>>;
+
+  template <class TExpr>
+  auto on(ut::events::assertion_pass<TExpr>) -> void {
+    ++passes;
+  }
+  template <class TExpr>
+  auto on(ut::events::assertion_fail<TExpr>) -> void {
+    ++fails;
+  }
+  template <class TMsg>
+  auto on(ut::events::log<TMsg>) -> void {
+    ++logs;
+  }
+
+  std::size_t passes{};
+  std::size_t fails{};
+  std::size_t logs{};
+};
+
+struct test_failures_runner : ut::runner<test_failures_reporter> {
+  using runner::reporter_;
+};
+
+struct test_state_reporter : test_failures_reporter {};
+struct test_state_runner : ut::runner<test_state_reporter> {};
+
+struct test_interrupt_reporter {
+  using subscribed_events =
+      ut::type_traits::list<ut::events::test_end, ut::events::exception,
+                            ut::events::log<>, ut::events::summary>;
+
+  auto on(ut::events::test_end test_end) const -> void {
+    std::cout << "end " << test_end.name << '\n';
+  }
+  auto on(ut::events::exception exception) const -> void {
+    std::cout << exception.what() << '\n';
+  }
+  template <class TMsg>
+  auto on(ut::events::log<TMsg>) const -> void {}
+  auto on(ut::events::summary) const -> void { std::cout << "summary\n"; }
+};
+struct test_interrupt_runner : ut::runner<test_interrupt_reporter> {};
+
 namespace ns {
 namespace {
 template <char... Cs>
@@ -325,6 +423,14 @@ auto f() -> int {
   using namespace ns;
   return 42_i;
 }
+
+/// uses about `depth` frames of `Size` bytes of stack
+template <std::size_t Size = 1024>
+auto recurse(const int depth) -> int {
+  volatile char frame[Size]{};
+  frame[0] = static_cast<char>(depth);
+  return depth ? recurse<Size>(depth - 1) + frame[0] : frame[0];
+}
 }  // namespace
 
 struct custom {
@@ -860,6 +966,950 @@ int main() {  // NOLINT(readability-function-size)
       test_assert(1 == run_count);
     }
 
+    {
+      test_metric_runner run;
+      ut::metric("outside any test", 1);
+      run.on(events::test<void (*)()>{
+          .type = "test",
+          .name = "metrics",
+          .location = {},
+          .arg = none{},
+          .run = [] {
+            ut::metric("bytes_copied", 10);
+            ut::metric("bytes_copied", 5);
+            auto hits = ut::counter("cache_hits");
+            hits++;
+            ++ut::counter("cache_hits");
+            std::thread{[] { ut::counter("cache_hits") += 3; }}.join();
+            test_assert(5 == ut::counter("cache_hits").get());
+            ut::gauge("queue_depth", 3);
+            ut::gauge("queue_depth", 7);
+          }});
+      run.on(events::test<void (*)()>{
+          .type = "test",
+          .name = "no metrics",
+          .location = {},
+          .arg = none{},
+          .run = [] {}});
+
+      const auto& metrics = run.reporter_.metrics;
+      test_assert(4 == std::size(metrics));
+      const auto find = [&](std::string_view name) {
+        return *std::find_if(metrics.cbegin(), metrics.cend(),
+                             [=](const auto& m) { return m.name == name; });
+      };
+      test_assert(1. == find("outside any test").value);
+      test_assert("metric" == find("bytes_copied").kind);
+      test_assert(15. == find("bytes_copied").value);
+      test_assert("counter" == find("cache_hits").kind);
+      test_assert(5. == find("cache_hits").value);
+      test_assert("gauge" == find("queue_depth").kind);
+      test_assert(7. == find("queue_depth").value);
+      test_assert(0 == ut::counter("cache_hits").get());
+    }
+
+    {
+      using fanout = ut::reporters<test_fanout_reporter<'a'>>;
+      constexpr auto handles = [](auto event) {
+        return requires(fanout r) { r.on(event); };
+      };
+      static_assert(handles(events::test_begin{}));
+      static_assert(not handles(events::test_skip{}));
+
+      std::string trace{};
+      {
+        test_fanout_runner run;
+        run.reporter_.get<test_fanout_reporter<'a'>>().trace = &trace;
+        run.reporter_.get<test_fanout_reporter<'b'>>().trace = &trace;
+        run.on(events::test<void (*)()>{
+            .type = "test",
+            .name = "fanout",
+            .location = {},
+            .arg = none{},
+            .run = [] { expect(true); }});
+        test_assert("abab" == trace);
+        auto& reporter = run.reporter_.get<test_quiet_reporter>();
+        test_assert(1 == reporter.tests_.pass);
+        run.report_summary();
+        test_assert("ababba" == trace);
+        reporter.asserts_ = {};
+      }
+    }
+
+    {
+      static_assert(ut::detail::is_subscribed<test_failures_reporter,
+                                              events::assertion_fail<int>>);
+      static_assert(not ut::detail::is_subscribed<
+                    test_failures_reporter, events::assertion_pass<int>>);
+      static_assert(not ut::detail::is_subscribed<test_failures_reporter,
+                                                  events::test_begin>);
+      static_assert(ut::detail::is_subscribed<test_reporter, events::summary>);
+      static_assert(
+          ut::reporters<test_reporter,
+                        test_failures_reporter>::subscribes<events::test_end>);
+
+      test_failures_runner run;
+      test_assert(run.on(events::assertion<bool>{.expr = true, .location = {}}));
+      test_assert(not run.on(events::assertion{1_i == 2, {}}));
+      run.on(events::log{"message"});
+      test_assert(0 == run.reporter_.passes);
+      test_assert(1 == run.reporter_.fails);
+      test_assert(1 == run.reporter_.logs);
+      test_assert(run.run());
+    }
+
+    {
+      auto paths = ut::detail::test_paths{};
+      paths.insert({"a", "b (1)"});
+      paths.insert({"a", "b (1)"});
+      test_assert(1 == paths.size());
+      const auto path = std::array<std::string_view, 3>{"a", "b (1)", "c"};
+      const auto other = std::array<std::string_view, 3>{"a", "b (2)", "c"};
+      test_assert(paths.matches(0, path));
+      test_assert(paths.matches(2, path));
+      test_assert(paths.matches(0, other));
+      test_assert(not paths.matches(1, other));
+      test_assert("a\tb (1)" == ut::detail::test_paths::to_line(*paths.begin()));
+      test_assert((std::vector<std::string>{"a", "b (1)"} ==
+                   ut::detail::test_paths::from_line("a\tb (1)")));
+
+      const auto file =
+          (std::filesystem::temp_directory_path() / "ut-test.ut-state").string();
+      std::ofstream{file} << "ut-state 1 build\nlf\tfail\nlf\tpass\nold\n";
+      ut::detail::cfg::state_file = file;
+      ut::detail::cfg::last_failed = true;
+      {
+        test_state_runner run;
+        test_assert(not run.run());
+        std::vector<std::string_view> ran{};
+        const auto nested = [&](std::string_view name, bool result) {
+          return events::test<std::function<void()>>{
+              .type = "test",
+              .name = std::string{name},
+              .location = {},
+              .arg = none{},
+              .run = [&, name, result] {
+                ran.push_back(name);
+                void(run.on(events::assertion<bool>{.expr = result,
+                                                    .location = {}}));
+              }};
+        };
+        run.on(events::test<std::function<void()>>{
+            .type = "test",
+            .name = "lf",
+            .location = {},
+            .arg = none{},
+            .run = [&] {
+              ran.push_back("lf");
+              run.on(nested("pass", true));
+              run.on(nested("fail", false));
+              run.on(nested("new", false));
+            }});
+        run.on(nested("other", false));
+        test_assert(
+            (std::vector<std::string_view>{"lf", "pass", "fail"} == ran));
+        run.report_summary();
+      }
+      ut::detail::cfg::state_file = {};
+      ut::detail::cfg::last_failed = false;
+
+      auto state = ut::detail::run_state{};
+      test_assert(state.load(file));
+      test_assert(state.build_id() != "build");
+      test_assert(2 == state.previous().size());
+      const auto lines = std::vector<std::string>{
+          ut::detail::test_paths::to_line(*state.previous().begin()),
+          ut::detail::test_paths::to_line(*std::next(state.previous().begin()))};
+      test_assert((std::vector<std::string>{"old", "lf\tfail"} == lines));
+      std::filesystem::remove(file);
+      test_assert(not state.load(file));
+    }
+
+    {
+      const auto file =
+          (std::filesystem::temp_directory_path() / "ut-test.tests").string();
+      std::ofstream{file} << "two\nthree\tnested\n";
+      ut::detail::cfg::input_filename = file;
+      {
+        test_failures_runner run;
+        test_assert(not run.run());
+        std::vector<std::string_view> ran{};
+        const auto test = [&](std::string_view name, auto body) {
+          run.on(events::test<std::function<void()>>{
+              .type = "test",
+              .name = std::string{name},
+              .location = {},
+              .arg = none{},
+              .run = [&ran, name, body] {
+                ran.push_back(name);
+                body();
+              }});
+        };
+        test("one", [] {});
+        test("two", [] {});
+        test("three", [&] {
+          test("other", [] {});
+          test("nested", [] {});
+        });
+        test_assert(
+            (std::vector<std::string_view>{"two", "three", "nested"} == ran));
+      }
+      ut::detail::cfg::input_filename = {};
+      std::filesystem::remove(file);
+    }
+
+    {
+      auto tests = std::vector<std::size_t>(32);
+      std::iota(tests.begin(), tests.end(), 0u);
+      const auto contains = [](const auto& ordinals, std::size_t ordinal) {
+        return std::find(ordinals.cbegin(), ordinals.cend(), ordinal) !=
+               ordinals.cend();
+      };
+
+      auto single = [&](const std::vector<std::size_t>& ordinals) {
+        return contains(ordinals, 21);
+      };
+      test_assert((std::vector<std::size_t>{21} ==
+                   ut::detail::bisect_pollution(tests, single)));
+
+      auto probes = 0u;
+      auto pair = [&](const std::vector<std::size_t>& ordinals) {
+        ++probes;
+        return contains(ordinals, 3) and contains(ordinals, 30);
+      };
+      test_assert((std::vector<std::size_t>{3, 30} ==
+                   ut::detail::bisect_pollution(tests, pair)));
+      test_assert(probes < 32);
+    }
+
+    {
+      static_assert(std::uniform_random_bit_generator<ut::detail::rng_>);
+      ut::detail::cfg::rnd_seed = 42;
+      const auto draw = [](std::uint64_t stream = 0) {
+        auto gen = ut::rng(stream);
+        return std::array{gen(), gen(), gen()};
+      };
+      test_assert(draw() == draw());
+      test_assert(draw() != draw(1));
+
+      auto gen = ut::rng();
+      gen.discard(2);
+      test_assert(draw()[2] == gen());
+      const auto die = std::uniform_int_distribution{1, 6}(gen);
+      test_assert(die >= 1 and die <= 6);
+
+      test_runner run;
+      run.run_ = true;
+      std::map<std::string, std::array<std::uint64_t, 3>> values{};
+      const auto test = [&](std::string name) {
+        return events::test<std::function<void()>>{
+            .type = "test",
+            .name = name,
+            .location = {},
+            .arg = none{},
+            .run = [&, name] { values[name] = draw(); }};
+      };
+      run.on(test("a"));
+      run.on(test("b"));
+      const auto first = values;
+      run.on(test("b"));
+      run.on(test("a"));
+      test_assert(first == values);
+      test_assert(values["a"] != values["b"]);
+      test_assert(values["a"] != draw());
+
+      ut::detail::cfg::rnd_seed = 43;
+      run.on(test("a"));
+      test_assert(first.at("a") != values["a"]);
+      ut::detail::cfg::rnd_seed = 0;
+    }
+
+    {
+      auto& test_cfg = ut::cfg<ut::override>;
+      test_cfg = fake_cfg{};
+      const auto sum = [](const std::vector<int>& v) {
+        return std::accumulate(v.cbegin(), v.cend(), 0);
+      };
+      const auto skips_sevens = [](const std::vector<int>& v) {
+        auto result = 0;
+        for (const auto i : v) {
+          result += i == 7 ? 0 : i;
+        }
+        return result;
+      };
+      const auto inputs =
+          std::vector<std::vector<int>>{{1, 2}, {3, 4, 5, 7, 9, 11}, {7}};
+      using ut::operators::operator|;
+      (ut::differential(sum, sum) | inputs)();
+      test_assert(test_cfg.assertion_calls.empty());
+
+      (ut::differential(sum, skips_sevens) | inputs)();
+      test_assert(1 == std::size(test_cfg.assertion_calls));
+      test_assert(not test_cfg.assertion_calls[0].result);
+      test_assert(1 == std::size(test_cfg.log_calls));
+      test_assert(
+          " candidate differs from reference for {7} (minimized from {3, 4, "
+          "5, 7, 9, 11}): 7 != 0" ==
+          std::any_cast<std::string>(test_cfg.log_calls[0]));
+
+      test_assert(ut::detail::shrinks(0).empty());
+      test_assert((std::vector{0, 10, -5, -9} == ut::detail::shrinks(-10)));
+      test_assert(0 == ut::detail::minimize(1000, [](int i) { return i >= 0; }));
+      test_assert(
+          17 == ut::detail::minimize(1000, [](int i) { return i >= 17; }));
+      test_cfg = fake_cfg{};
+    }
+
+    {
+      auto& test_cfg = ut::cfg<ut::override>;
+      test_cfg = fake_cfg{};
+      const auto file =
+          (std::filesystem::temp_directory_path() / "ut-test-rows.csv").string();
+      std::ofstream{file} << "a,b\n1,x\n";
+      using ut::operators::operator|;
+      const auto location = ut::reflection::source_location::current();
+      ([](int, int) {} | ut::rows_from(file, location).skip_header())("test",
+                                                                      "rows");
+      test_assert(1 == std::size(test_cfg.run_calls));
+      test_assert(1 == std::size(test_cfg.assertion_calls));
+      test_assert(not test_cfg.assertion_calls[0].result);
+      test_assert(location.line() ==
+                  test_cfg.assertion_calls[0].location.line());
+      test_assert(" " + file + ":2: cannot convert the fields to the test "
+                  "arguments\n" ==
+                  std::any_cast<std::string>(test_cfg.log_calls[0]));
+      std::filesystem::remove(file);
+      test_cfg = fake_cfg{};
+    }
+
+    {
+      test_metric_runner run;
+      using ut::operators::operator|;
+      ut::detail::metrics::drain([](const auto&) {});  // of the tests above
+      std::mutex mutex{};
+      std::set<std::uint64_t> random{};
+      std::atomic<std::size_t> issued{};
+      run.on(events::test<std::function<void()>>{
+          .type = "load",
+          .name = "open loop",
+          .location = {},
+          .arg = none{},
+          .run = ut::rate(2'000, std::chrono::milliseconds{250}, 2) |
+                 [&](ut::load_ctx& ctx) {
+                   ++issued;
+                   if (ctx.op() < 10) {  // of the test, on either worker
+                     const std::scoped_lock lock{mutex};
+                     random.insert(ut::rng()());
+                   }
+                   // both workers stall, later operations queue up
+                   if (ctx.op() == 100 or ctx.op() == 101) {
+                     std::this_thread::sleep_for(std::chrono::milliseconds{20});
+                   }
+                   if (ctx.op() % 10 == 0) {
+                     ctx.error();
+                   }
+                 }});
+
+      const auto& metrics = run.reporter_.metrics;
+      const auto find = [&](std::string_view name) {
+        return std::find_if(metrics.cbegin(), metrics.cend(),
+                            [=](const auto& m) { return m.name == name; })
+            ->value;
+      };
+      test_assert(8 == std::size(metrics));
+      test_assert(50. == find("errors"));
+      test_assert(find("late") > 0);  // behind the sleeping operations
+      test_assert(500 == issued);  // 2'000 per second for 250ms
+      test_assert(find("ops_per_s") > 0);
+      test_assert(find("p50_us") <= find("p999_us"));
+      test_assert(1 == random.size());
+      test_assert(not random.contains(ut::rng()()));
+    }
+
+    {
+      const auto file =
+          (std::filesystem::temp_directory_path() / "ut-test.ut-journal")
+              .string();
+      static std::vector<std::string> ran{};
+      static test_runner* current{};
+      static constexpr auto test = [](std::string name, bool result) {
+        return events::test<std::function<void()>>{
+            .type = "test",
+            .name = name,
+            .location = {},
+            .arg = none{},
+            .run = [name, result] {
+              ran.push_back(name);
+              void(current->on(
+                  events::assertion<bool>{.expr = result, .location = {}}));
+            }};
+      };
+      const auto suite = +[] {
+        current->on(test("a", true));
+        current->on(test("b", false));
+        current->on(test("a", true));  // same name, not journaled
+        current->on(test("d", true));
+      };
+
+      ut::detail::cfg::journal = file;
+      {
+        test_runner run;
+        current = &run;
+        test_assert(not run.run());
+        run.on(test("a", true));
+        run.on(test("b", false));
+      }
+      auto entries = ut::detail::journal::load(file);
+      test_assert(2 == entries.size());
+      test_assert("a" == entries[0].name and entries[0].passed);
+      test_assert("b" == entries[1].name and not entries[1].passed);
+      test_assert(entries[0].worker == entries[1].worker);
+
+      std::ofstream{file, std::ios::app} << "0\tpa";  // torn by a crash
+      ut::detail::cfg::journal = {};
+      ut::detail::cfg::resume = file;
+      ran.clear();
+      {
+        test_runner run;
+        current = &run;
+        const auto pass = run.reporter_.tests_.pass;
+        const auto fail = run.reporter_.tests_.fail;
+        test_assert(not run.run());
+        run.on(test("a", true));
+        run.on(test("b", true));
+        run.on(test("c", true));
+        test_assert((std::vector<std::string>{"c"} == ran));
+        test_assert(pass + 2 == run.reporter_.tests_.pass);
+        test_assert(fail + 1 == run.reporter_.tests_.fail);
+      }
+      test_assert(3 == ut::detail::journal::load(file).size());
+      test_assert(2 == ut::detail::journal::load(file)[2].ordinal);
+
+      // ran concurrently on another worker, without the last failure
+      std::ofstream{file, std::ios::app} << "7\tpass\t3\td\n";
+      ut::detail::cfg::resume = {};
+      ut::detail::cfg::replay = file;
+      ran.clear();
+      {
+        test_runner run;
+        current = &run;
+        run.on(events::suite<void (*)()>{.run = suite, .name = "replay"});
+        test_assert(run.run());
+        test_assert((std::vector<std::string>{"a", "b"} == ran));
+      }
+      ut::detail::cfg::replay = {};
+      std::filesystem::remove(file);
+    }
+
+#if __has_include(<ucontext.h>) and __has_include(<sys/mman.h>)
+    {
+      test_metric_runner run;
+      const auto test = [](std::string name, int depth,
+                           std::size_t max_stack) {
+        return events::test<std::function<void()>>{
+            .type = "test",
+            .name = name,
+            .tag = {},
+            .max_stack = max_stack,
+            .location = {},
+            .arg = none{},
+            .run = [depth] { static_cast<void>(recurse(depth)); }};
+      };
+      const auto tagged = ut::max_stack(16 * 1024) / ut::test("tagged");
+      test_assert(tagged.tag.empty());
+      run.on(test("shallow", 1, tagged.max_stack));
+      ut::detail::cfg::stack_usage = 1024 * 1024;
+      run.on(test("measured", 64, 0));
+      ut::detail::cfg::stack_usage = 0;
+      run.on(test("unmeasured", 64, 0));
+
+      const auto& metrics = run.reporter_.metrics;
+      test_assert(2 == std::size(metrics));
+      test_assert("stack" == metrics[0].name and "gauge" == metrics[0].kind);
+      test_assert(metrics[0].value > 1024 and metrics[0].value < 16 * 1024);
+      test_assert(metrics[1].value > 64 * 1024);
+
+      test_runner failures;
+      failures.run_ = true;
+      const auto fail = failures.reporter_.tests_.fail;
+      failures.on(test("shallow", 1, 16 * 1024));
+      test_assert(fail == failures.reporter_.tests_.fail);
+      failures.on(test("deep", 64, 16 * 1024));
+      test_assert(fail + 1 == failures.reporter_.tests_.fail);
+      failures.on(test("overflows", 1024, 16 * 1024));  // of 256KiB
+      test_assert(fail + 2 == failures.reporter_.tests_.fail);
+      failures.on(test("shallow again", 1, 16 * 1024));
+      test_assert(fail + 2 == failures.reporter_.tests_.fail);
+      failures.on(events::test<std::function<void()>>{
+          .type = "test",
+          .name = "overflows in 32KiB frames",
+          .tag = {},
+          .max_stack = 16 * 1024,
+          .location = {},
+          .arg = none{},
+          .run = [] { static_cast<void>(recurse<32 * 1024>(64)); }});
+      test_assert(fail + 3 == failures.reporter_.tests_.fail);
+      const auto pass = failures.reporter_.tests_.pass;
+      failures.on(events::test<std::function<void()>>{
+          .type = "test",
+          .name = "overflows in a nested test",
+          .tag = {},
+          .max_stack = 16 * 1024,
+          .location = {},
+          .arg = none{},
+          .run = [&] { failures.on(test("nested", 1024, 0)); }});
+      test_assert(fail + 4 == failures.reporter_.tests_.fail);
+      failures.on(test("top-level again", 1, 16 * 1024));
+      test_assert(pass + 1 == failures.reporter_.tests_.pass);
+      test_assert(fail + 4 == failures.reporter_.tests_.fail);
+    }
+#endif
+
+    if (std::filesystem::exists("/proc/self/fd")) {
+      test_runner run;
+      run.run_ = true;
+      std::FILE* leaked{};
+      const auto test = [&](std::string name, std::function<void()> body) {
+        return events::test<std::function<void()>>{.type = "test",
+                                                   .name = name,
+                                                   .location = {},
+                                                   .arg = none{},
+                                                   .run = body};
+      };
+      const auto fail = run.reporter_.tests_.fail;
+      ut::detail::cfg::leak_check = "fail";
+      run.on(test("closes", [] { std::fclose(std::fopen("/dev/null", "r")); }));
+      test_assert(fail == run.reporter_.tests_.fail);
+      run.on(test("leaks", [&] { leaked = std::fopen("/dev/null", "r"); }));
+      test_assert(fail + 1 == run.reporter_.tests_.fail);
+      run.on(test("joins", [] { std::thread{[] {}}.join(); }));
+      test_assert(fail + 1 == run.reporter_.tests_.fail);
+      ut::detail::cfg::leak_check = "off";
+      std::fclose(leaked);
+
+      const auto before = ut::detail::resources::snapshot();
+      leaked = std::fopen("/dev/null", "r");
+      const auto leaks = ut::detail::resources::snapshot().leaked_since(before);
+      test_assert(1 == leaks.size());
+      test_assert(leaks[0].starts_with("fd ") and
+                  leaks[0].ends_with(" (/dev/null)"));
+      std::fclose(leaked);
+    }
+
+#if __has_include(<execinfo.h>) and __has_include(<sys/time.h>)
+    {
+      const auto file =
+          (std::filesystem::temp_directory_path() / "ut-test.folded").string();
+      static test_runner* current{};
+      const auto suite = +[] {
+        current->on(events::test<std::function<void()>>{
+            .type = "test",
+            .name = "busy",
+            .location = {},
+            .arg = none{},
+            .run = [] {
+              for (const auto start = std::clock();
+                   std::clock() - start < CLOCKS_PER_SEC / 20;) {
+              }
+            }});
+      };
+      ut::detail::cfg::profile = file;
+      {
+        test_runner run;
+        current = &run;
+        run.on(events::suite<void (*)()>{.run = suite, .name = "profiled"});
+        test_assert(not run.run());
+      }
+      ut::detail::cfg::profile = {};
+      auto samples = 0ul;
+      auto lambda = false;  // not exported, named by addr2line
+      auto in = std::ifstream{file};
+      for (auto line = std::string{}; std::getline(in, line);) {
+        test_assert(line.starts_with("profiled;busy;"));
+        samples += std::stoul(line.substr(line.rfind(' ') + 1));
+        lambda |= line.find("main::{lambda") != std::string::npos;
+      }
+      test_assert(samples > 10);
+      test_assert(lambda or std::system("addr2line --version >/dev/null 2>&1"));
+      std::filesystem::remove(file);
+    }
+#endif
+
+    {
+      const auto file =
+          (std::filesystem::temp_directory_path() / "ut-test.markers").string();
+      std::filesystem::remove(file);
+      static test_runner* current{};
+      const auto suite = +[] {
+        current->on(events::test<std::function<void()>>{
+            .type = "test",
+            .name = "traced",
+            .location = {},
+            .arg = none{},
+            .run = [] {
+              void(current->on(events::assertion<bool>{
+                  .expr = false,
+                  .location = ut::reflection::source_location::current()}));
+              const auto id = ut::detail::trace::running();
+              auto other = std::size_t{1};
+              std::thread{[&] { other = ut::detail::trace::running(); }}.join();
+              test_assert(id and not other);  // per thread
+            }});
+      };
+      ut::detail::cfg::trace_markers = file;
+      {
+        test_runner run;
+        current = &run;
+        run.on(events::suite<void (*)()>{.run = suite, .name = "markers"});
+        test_assert(run.run());
+      }
+      ut::detail::cfg::trace_markers = {};
+      auto lines = std::vector<std::string>{};
+      auto in = std::ifstream{file};
+      for (auto line = std::string{}; std::getline(in, line);) {
+        lines.push_back(line);
+      }
+      test_assert(5 == lines.size());
+      test_assert("boost_ut suite_begin markers" == lines[0]);
+      test_assert(lines[1].starts_with("boost_ut test_begin ") and
+                  lines[1].ends_with(" traced"));
+      const auto id = lines[1].substr(20, lines[1].size() - 27);
+      test_assert(lines[2].starts_with("boost_ut assertion_fail " + id + ' ') and
+                  lines[2].find("ut.cpp:") != std::string::npos);
+      test_assert("boost_ut test_end fail " + id + " traced" == lines[3]);
+      test_assert("boost_ut suite_end markers" == lines[4]);
+      std::filesystem::remove(file);
+    }
+
+    {
+      using ut::detail::parse_duration;
+      test_assert(std::chrono::hours{2} == parse_duration("2h"));
+      test_assert(std::chrono::milliseconds{1500} == parse_duration("1.5s"));
+      test_assert(std::chrono::milliseconds{500} == parse_duration("500ms"));
+      test_assert(std::chrono::seconds{30} == parse_duration("30"));
+      test_assert(0 == parse_duration("2x").count());
+      test_assert(0 == parse_duration("-1m").count());
+
+      static test_runner* current{};
+      static std::vector<std::vector<char>> kept{};
+      const auto suite = +[] {
+        const auto test = [](std::string name, void (*body)()) {
+          current->on(events::test<void (*)()>{.type = "test",
+                                               .name = name,
+                                               .location = {},
+                                               .arg = none{},
+                                               .run = body});
+        };
+        test("steady", [] {
+          std::this_thread::sleep_for(std::chrono::microseconds{500});
+        });
+        test("growing", [] {
+          kept.emplace_back(64 * 1024, 'x');
+          std::this_thread::sleep_for(std::chrono::microseconds{500});
+        });
+      };
+      ut::detail::cfg::soak = "200ms";
+      {
+        test_runner run;
+        current = &run;
+        run.on(events::suite<void (*)()>{.run = suite, .name = "soaked"});
+        const auto fail = run.reporter_.tests_.fail;
+        test_assert(run.run());
+        test_assert(fail + 1 == run.reporter_.tests_.fail);
+      }
+      ut::detail::cfg::soak = {};
+      test_assert(kept.size() > 100);
+      kept.clear();
+    }
+
+    {
+      using ut::detail::durations;
+      using ms = std::chrono::milliseconds;
+      const auto file =
+          (std::filesystem::temp_directory_path() / "ut-test.ut-durations")
+              .string();
+      std::filesystem::remove(file);
+      for (auto run = 0; run < 5; ++run) {
+        auto history = durations{};
+        history.load(file);
+        test_assert(history.slowdown("a", ms{1000}).empty());
+        history.append("a", {.took = ms{100 + run}, .passed = true});
+        history.append("b", {.took = ms{1}, .passed = true});
+        history.append("c", {.took = ms{1000}, .passed = false});
+        history.save();
+      }
+      auto history = durations{};
+      history.load(file);
+      test_assert(history.slowdown("a", ms{140}).empty());
+      test_assert("took 160ms, usually 102ms (median of 5 runs)" ==
+                  history.slowdown("a", ms{160}));
+      test_assert(history.slowdown("b", ms{40}).empty());
+      test_assert(not history.slowdown("b", ms{60}).empty());
+      test_assert(history.slowdown("c", ms{2000}).empty());
+      test_assert(history.slowdown("d", ms{1000}).empty());
+
+      for (auto run = 0u; run < 8 * durations::window; ++run) {
+        auto next = durations{};
+        next.load(file);
+        next.append("a", {.took = ms{100}, .passed = true});
+        next.save();
+      }
+      auto lines = 0u;
+      auto in = std::ifstream{file};
+      for (auto line = std::string{}; std::getline(in, line);) {
+        ++lines;
+      }
+      test_assert(lines < 1 + 15 + 8 * durations::window);  // compacted
+      std::filesystem::remove(file);
+
+#if __has_include(<unistd.h>) and __has_include(<sys/wait.h>)
+      // shards appending while another one compacts, every test is kept
+      constexpr auto shards = 4;
+      constexpr auto runs = 6 * durations::window;
+      for (auto shard = 0; shard < shards; ++shard) {
+        if (fork() == 0) {
+          for (auto run = 0u; run < runs; ++run) {
+            auto next = durations{};
+            next.load(file);
+            next.append(std::to_string(shard), {.took = ms{run}, .passed = true});
+            next.save();
+          }
+          std::_Exit(0);
+        }
+      }
+      for (auto shard = 0; shard < shards; ++shard) {
+        wait(nullptr);
+      }
+      history = durations{};
+      history.load(file);
+      for (auto shard = 0; shard < shards; ++shard) {
+        const auto& kept = history.history().at(std::to_string(shard));
+        test_assert(durations::window == kept.size());
+        for (auto i = 0u; i < kept.size(); ++i) {
+          test_assert(ms{runs - durations::window + i} == kept[i].took);
+        }
+      }
+      std::filesystem::remove(file);
+#endif
+    }
+
+    {
+      using seconds = std::chrono::seconds;
+      const auto file =
+          (std::filesystem::temp_directory_path() / "ut-test.ut-durations")
+              .string();
+      const auto source =
+          (std::filesystem::temp_directory_path() / "ut-test-changed.cpp")
+              .string();
+      std::filesystem::remove(file);
+      {
+        auto history = ut::detail::durations{};
+        history.load(file);
+        for (auto run = 0; run < 4; ++run) {
+          history.append("fragile", {.took = seconds{10}, .passed = run % 2 == 0});
+          history.append("stable", {.took = seconds{10}, .passed = true});
+          history.append("slow", {.took = seconds{60}, .passed = false});
+        }
+        history.save();
+      }
+      std::ofstream{source} << '\n';
+      std::filesystem::last_write_time(
+          source, std::filesystem::last_write_time(file) + std::chrono::hours{1});
+
+      auto history = ut::detail::durations{};
+      history.load(file);
+      auto budget = ut::detail::time_budget{};
+      test_assert(not budget);
+      budget.start(seconds{15}, history);
+      test_assert(static_cast<bool>(budget));
+      test_assert(budget.admit("fragile", "fragile.cpp"));
+      test_assert(not budget.admit("stable", "stable.cpp"));
+      test_assert(budget.admit("stable", source.c_str()));
+      test_assert(budget.admit("new", "new.cpp"));
+      test_assert(not budget.admit("slow", "slow.cpp"));
+      test_assert(not budget.admit("slow", source.c_str()));
+      auto report = std::ostringstream{};
+      budget.report(report);
+      test_assert(report.str().starts_with(
+          "time budget of 15.0s: ran 3 tests in 0.0s, skipped 3\n"));
+      test_assert(report.str().find("  stable (not picked)\n") !=
+                  std::string::npos);
+      test_assert(report.str().find("  slow (not picked)\n") !=
+                  std::string::npos);
+      test_assert(report.str().find(
+                      "  slow (would not finish before the deadline)\n") !=
+                  std::string::npos);
+
+      auto displacing = ut::detail::time_budget{};
+      displacing.start(seconds{25}, history);
+      test_assert(displacing.admit("new", "new.cpp"));
+      test_assert(displacing.admit("fragile", "fragile.cpp"));
+      test_assert(not displacing.admit("stable", "stable.cpp"));
+      report = std::ostringstream{};
+      displacing.report(report);
+      test_assert(report.str().find(
+                      "  stable (displaced by new or changed tests)\n") !=
+                  std::string::npos);
+
+      auto short_budget = ut::detail::time_budget{};
+      short_budget.start(seconds{5}, history);
+      test_assert(not short_budget.admit("new", "new.cpp"));  // ~10s as usual
+
+      std::filesystem::remove(file);
+      std::filesystem::remove(source);
+    }
+
+    {
+      test_runner run;
+      run.run_ = true;
+      auto& reporter = run.reporter_;
+      const auto asserts = reporter.asserts_;
+      const auto tests = reporter.tests_;
+      std::mutex mutex{};
+      std::vector<std::string_view> ran{};
+      auto declared = false;
+      run.on(events::test<std::function<void()>>{
+          .type = "test",
+          .name = "parent",
+          .location = {},
+          .arg = none{},
+          .run = [&] {
+            run.on(events::parallel_begin{});
+            for (const auto name : {"a"sv, "b"sv, "c"sv}) {
+              run.on(events::test<std::function<void()>>{
+                  .type = "test",
+                  .name = std::string{name},
+                  .location = {},
+                  .arg = none{},
+                  .run = [&, name] {
+                    test_assert(declared);
+                    {
+                      const auto lock = std::lock_guard{mutex};
+                      ran.push_back(name);
+                    }
+                    void(run.on(events::assertion<bool>{.expr = name != "b",
+                                                        .location = {}}));
+                  }});
+            }
+            declared = true;
+            run.on(events::parallel_end{});
+            test_assert(3 == ran.size());
+          }});
+      test_assert(asserts.pass + 2 == reporter.asserts_.pass);
+      test_assert(asserts.fail + 1 == reporter.asserts_.fail);
+      test_assert(tests.fail + 1 == reporter.tests_.fail);
+    }
+
+#if __has_include(<unistd.h>) and __has_include(<sys/wait.h>)
+    // reported by the runner thread at its next event, or by the watcher when
+    // the test is stuck (which leaves the reporter alone)
+    for (const auto stuck : {false, true}) {
+      int fds[2]{};
+      test_assert(not pipe(fds));
+      std::cout.flush();
+      if (const auto pid = fork(); not pid) {
+        dup2(fds[1], STDOUT_FILENO);
+        if (stuck) {
+          dup2(fds[1], STDERR_FILENO);
+          ut::detail::cfg::durations_file = "none";
+          ut::detail::cfg::time_budget = "100ms";
+        }
+        test_interrupt_runner run;
+        void(run.run());
+        run.on(events::test<std::function<void()>>{
+            .type = "test",
+            .name = "interrupted",
+            .location = {},
+            .arg = none{},
+            .run = [&run, stuck] {
+              if (stuck) {
+                std::this_thread::sleep_for(std::chrono::seconds{10});
+              }
+              std::thread{[] { raise(SIGTERM); }}.join();
+              for (;;) {  // passing assertions do not report it
+                void(run.on(events::assertion<bool>{.expr = true,
+                                                    .location = {}}));
+                run.on(events::log<std::string_view>{.msg = ""});
+              }
+            }});
+        std::_Exit(0);
+      } else {
+        close(fds[1]);
+        auto output = std::string{};
+        char buffer[256];
+        for (ssize_t n{}; (n = read(fds[0], buffer, sizeof(buffer))) > 0;) {
+          output.append(buffer, static_cast<std::size_t>(n));
+        }
+        close(fds[0]);
+        auto status = 0;
+        waitpid(pid, &status, 0);
+        test_assert(WIFEXITED(status) and
+                    128 + (stuck ? SIGALRM : SIGTERM) == WEXITSTATUS(status));
+        test_assert(
+            (stuck ? "\nexceeded the time budget: \"interrupted\" did not "
+                     "return within 100ms\n"
+                   : "interrupted by SIGTERM\nend interrupted\nsummary\n") ==
+            output);
+      }
+    }
+#endif
+
+    {
+      using namespace std::chrono_literals;
+      static_assert(std::chrono::is_clock_v<virtual_clock>);
+
+      test_assert(virtual_clock::reset());
+      test_assert(virtual_clock::time_point{} == virtual_clock::now());
+
+      const auto start = std::chrono::steady_clock::now();
+      virtual_clock::sleep_for(10min);
+      test_assert(virtual_clock::time_point{10min} == virtual_clock::now());
+      test_assert(std::chrono::steady_clock::now() - start < 10s);
+
+      std::vector<int> fired{};
+      virtual_clock::call_after(2s, [&] { fired.push_back(2); });
+      virtual_clock::call_after(1s, [&] { fired.push_back(1); });
+      virtual_clock::call_after(1h, [&] { fired.push_back(3); });
+      virtual_clock::advance(5s);
+      test_assert((std::vector{1, 2} == fired));
+      virtual_clock::sleep_for(2h);
+      test_assert((std::vector{1, 2, 3} == fired));
+
+      test_assert(virtual_clock::reset());
+      std::vector<std::string_view> woken{};
+      {
+        std::mutex mutex{};
+        std::atomic<bool> busy{true};
+        const auto sleeper = [&](virtual_clock::duration d,
+                                 std::string_view name) {
+          return virtual_clock::thread{[&mutex, &woken, d, name] {
+            virtual_clock::sleep_for(d);
+            const std::scoped_lock lock{mutex};
+            woken.push_back(name);
+          }};
+        };
+        auto slow = sleeper(5s, "slow");
+        auto fast = sleeper(3s, "fast");
+        auto worker = virtual_clock::thread{[&busy] {
+          while (busy) {  // not asleep, time must not move
+            std::this_thread::yield();
+          }
+          virtual_clock::sleep_for(4s);
+        }};
+        auto release = std::thread{[&busy] {
+          std::this_thread::sleep_for(std::chrono::milliseconds{20});
+          busy = false;
+        }};
+        virtual_clock::sleep_for(1s);  // not a participant, doesn't count
+        release.join();
+        test_assert(not busy);
+        slow.join();
+        fast.join();
+      }
+      test_assert((std::vector<std::string_view>{"fast", "slow"} == woken));
+      test_assert(virtual_clock::time_point{5s} == virtual_clock::now());
+    }
+
     auto& test_cfg = ut::cfg<ut::override>;
 
     {
@@ -1485,6 +2535,34 @@ int main() {  // NOLINT(readability-function-size)
     }
 #endif
 
+    {
+      using namespace std::chrono_literals;
+      test_cfg = fake_cfg{};
+
+      "eventually"_test = [] {
+        auto checks = 0;
+        expect(eventually([&] { return ++checks == 3; }, 1s));
+        expect(eventually([&] { return checks == 4_i; }, 1ms));
+
+        ut::notifier ready{};
+        std::atomic<bool> done{};
+        std::thread worker{[&] {
+          done = true;
+          ready.notify();
+        }};
+        expect(eventually([&] { return done.load(); }, 1h, ready));
+        worker.join();
+      };
+
+      test_assert(3 == std::size(test_cfg.assertion_calls));
+      test_assert(test_cfg.assertion_calls[0].result);
+      test_assert("eventually(true)" == test_cfg.assertion_calls[0].expr);
+      test_assert(not test_cfg.assertion_calls[1].result);
+      test_assert(test_cfg.assertion_calls[1].expr.starts_with(
+          "eventually(3 == 4) after "));
+      test_assert(test_cfg.assertion_calls[2].result);
+    }
+
     {
       test_cfg = fake_cfg{};
       [[maybe_unused]] struct {
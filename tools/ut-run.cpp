@@ -0,0 +1,534 @@
+//
+// Copyright (c) 2019-2020 Kris Jusiak (kris at jusiak dot net)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ut-run: runs the tests of many ut executables as one job queue.
+//
+// Each executable is asked for its top-level tests (--list-test-names-only),
+// the tests are grouped into batches of roughly --batch-time seconds based on
+// the durations of previous runs and the batches are run longest first (LPT)
+// on at most --jobs processes, honouring a GNU make jobserver. The JUnit
+// reports of all batches are merged into a single report.
+//
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+namespace fs = std::filesystem;
+using clock_type = std::chrono::steady_clock;
+
+constexpr auto unknown_duration = 0.1;  // seconds, for tests without history
+
+struct options {
+  std::size_t jobs = std::max(1u, std::thread::hardware_concurrency());
+  double batch_time = 1.0;
+  std::string output_filename{};
+  std::string durations_filename = "ut-run.durations";
+  std::vector<std::string> executables{};
+};
+
+auto print_usage() -> void {
+  std::cout
+      << "ut-run [options] <test executable>...\n\nwith options:\n"
+         "  -j, --jobs <n>                max. number of parallel jobs\n"
+         "  -o, --out <filename>          merged JUnit report\n"
+         "  --batch-time <seconds>        target duration of a batch (1)\n"
+         "  --durations <filename|none>   test durations of previous runs\n"
+         "                                (defaults to ut-run.durations)\n";
+}
+
+[[nodiscard]] auto parse(int argc, const char* argv[]) -> options {
+  auto opts = options{};
+  for (auto i = 1; i < argc; ++i) {
+    const auto arg = std::string_view{argv[i]};
+    const auto value = [&]() -> std::string {
+      if (i + 1 >= argc) {
+        std::cerr << "missing argument for option " << arg << std::endl;
+        std::exit(2);
+      }
+      return argv[++i];
+    };
+    const auto number = [&](auto& result) {
+      const auto text = value();
+      const auto [end, ec] =
+          std::from_chars(text.data(), text.data() + text.size(), result);
+      if (ec != std::errc{} or end != text.data() + text.size()) {
+        std::cerr << "invalid argument for option " << arg << ": '" << text
+                  << "'" << std::endl;
+        std::exit(2);
+      }
+    };
+    if (arg == "-h" or arg == "--help") {
+      print_usage();
+      std::exit(0);
+    } else if (arg == "-j" or arg == "--jobs") {
+      number(opts.jobs);
+      opts.jobs = std::max<std::size_t>(1, opts.jobs);
+    } else if (arg == "-o" or arg == "--out") {
+      opts.output_filename = value();
+    } else if (arg == "--batch-time") {
+      number(opts.batch_time);
+    } else if (arg == "--durations") {
+      opts.durations_filename = value();
+    } else if (arg.starts_with("-")) {
+      std::cerr << "unknown option: '" << arg << "'" << std::endl;
+      std::exit(2);
+    } else {
+      opts.executables.emplace_back(fs::absolute(arg).string());
+    }
+  }
+  return opts;
+}
+
+/// Client side of the GNU make jobserver (MAKEFLAGS=--jobserver-auth=R,W or
+/// fifo:PATH). We implicitly own one job slot, every further job needs a
+/// token read from the jobserver which is written back once the job is done.
+class jobserver {
+ public:
+  [[nodiscard]] static auto from_env() -> std::optional<jobserver> {
+    const auto* makeflags = std::getenv("MAKEFLAGS");
+    if (makeflags == nullptr) {
+      return std::nullopt;
+    }
+    auto flags = std::istringstream{makeflags};
+    auto auth = std::string{};
+    for (auto flag = std::string{}; flags >> flag;) {
+      for (const auto prefix : {"--jobserver-auth=", "--jobserver-fds="}) {
+        if (flag.starts_with(prefix)) {
+          auth = flag.substr(std::string_view{prefix}.size());
+        }
+      }
+    }
+    if (auth.starts_with("fifo:")) {
+      const auto fd = ::open(auth.c_str() + 5, O_RDWR | O_NONBLOCK);
+      if (fd < 0) {
+        return std::nullopt;
+      }
+      return jobserver{fd, fd};
+    }
+    auto in = -1;
+    auto out = -1;
+    if (std::sscanf(auth.c_str(), "%d,%d", &in, &out) != 2 or
+        ::fcntl(in, F_GETFD) < 0 or ::fcntl(out, F_GETFD) < 0) {
+      return std::nullopt;
+    }
+    return jobserver{in, out};
+  }
+
+  /// @return a token if one becomes available within `timeout`
+  [[nodiscard]] auto acquire(std::chrono::milliseconds timeout) const
+      -> std::optional<char> {
+    auto fd = pollfd{.fd = in_, .events = POLLIN, .revents = 0};
+    if (::poll(&fd, 1, static_cast<int>(timeout.count())) <= 0) {
+      return std::nullopt;
+    }
+    auto token = char{};
+    if (::read(in_, &token, 1) != 1) {  // another client was faster
+      return std::nullopt;
+    }
+    return token;
+  }
+
+  auto release(char token) const -> void {
+    while (::write(out_, &token, 1) < 0 and errno == EINTR) {
+    }
+  }
+
+ private:
+  jobserver(int in, int out) : in_{in}, out_{out} {}
+
+  int in_{};
+  int out_{};
+};
+
+struct job {
+  std::vector<std::string> args{};
+  fs::path log{};
+  std::function<void(int status, double seconds)> done{};
+};
+
+/// runs `jobs` on at most `max_jobs` processes, longest first if sorted so
+auto run(std::vector<job>& jobs, std::size_t max_jobs,
+         const std::optional<jobserver>& server) -> void {
+  struct running {
+    std::size_t job{};
+    std::optional<char> token{};
+    clock_type::time_point start{};
+  };
+  auto active = std::map<pid_t, running>{};
+  auto implicit_slot = true;
+  auto next = std::size_t{};
+
+  const auto spawn = [&](std::optional<char> token) {
+    const auto& [args, log, _] = jobs[next];
+    std::cout.flush();
+    std::cerr.flush();
+    const auto start = clock_type::now();
+    const auto pid = ::fork();
+    if (pid == 0) {
+      const auto fd = ::open(log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if (fd < 0) {
+        std::perror(log.c_str());
+        std::_Exit(127);
+      }
+      ::dup2(fd, STDOUT_FILENO);
+      ::dup2(fd, STDERR_FILENO);
+      auto argv = std::vector<char*>{};
+      for (const auto& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+      }
+      argv.push_back(nullptr);
+      ::execv(argv[0], argv.data());
+      std::_Exit(127);
+    }
+    active.emplace(pid, running{next++, token, start});
+  };
+
+  while (next < jobs.size() or not active.empty()) {
+    auto want_token = false;
+    while (next < jobs.size() and active.size() < max_jobs) {
+      if (implicit_slot) {
+        implicit_slot = false;
+        spawn(std::nullopt);
+      } else if (not server) {
+        spawn(std::nullopt);
+      } else if (const auto token =
+                     server->acquire(std::chrono::milliseconds{0})) {
+        spawn(token);
+      } else {
+        want_token = true;
+        break;
+      }
+    }
+
+    auto status = 0;
+    const auto pid = ::waitpid(-1, &status, want_token ? WNOHANG : 0);
+    if (pid == 0) {  // wait for a token or a finished job, whichever first
+      if (const auto token = server->acquire(std::chrono::milliseconds{10})) {
+        spawn(token);
+      }
+      continue;
+    }
+    if (pid < 0) {
+      continue;
+    }
+    const auto it = active.find(pid);
+    if (it == active.end()) {
+      continue;
+    }
+    const auto [index, token, start] = it->second;
+    active.erase(it);
+    if (token) {
+      server->release(*token);
+    } else {
+      implicit_slot = true;
+    }
+    jobs[index].done(
+        status, std::chrono::duration<double>(clock_type::now() - start).count());
+  }
+}
+
+[[nodiscard]] auto read_file(const fs::path& path) -> std::string {
+  auto in = std::ifstream{path};
+  return {std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+}
+
+/// the value of the attribute `name` of `tag`, with its XML escapes replaced
+[[nodiscard]] auto attribute(std::string_view tag, std::string_view name)
+    -> std::string {
+  const auto key = " " + std::string{name} + "=\"";
+  const auto begin = tag.find(key);
+  if (begin == std::string_view::npos) {
+    return {};
+  }
+  auto value = tag.substr(begin + key.size());
+  value = value.substr(0, value.find('"'));
+  static constexpr std::pair<std::string_view, char> entities[]{
+      {"&amp;", '&'},  {"&lt;", '<'},   {"&gt;", '>'},
+      {"&quot;", '"'}, {"&apos;", '\''}};
+  auto unescaped = std::string{};
+  while (not value.empty()) {
+    const auto entity = std::find_if(
+        std::begin(entities), std::end(entities),
+        [&](const auto& e) { return value.starts_with(e.first); });
+    if (entity != std::end(entities)) {
+      unescaped += entity->second;
+      value.remove_prefix(entity->first.size());
+    } else {
+      unescaped += value.front();
+      value.remove_prefix(1);
+    }
+  }
+  return unescaped;
+}
+
+[[nodiscard]] auto to_number(std::string_view value) -> double {
+  return value.empty() ? 0. : std::strtod(std::string{value}.c_str(), nullptr);
+}
+
+/// durations of the top-level tests of previous runs, by executable and name
+class durations {
+ public:
+  explicit durations(std::string filename) : filename_{std::move(filename)} {
+    auto in = std::ifstream{filename_ == "none" ? "" : filename_};
+    for (auto line = std::string{}; std::getline(in, line);) {
+      const auto tab = line.rfind('\t');
+      if (tab != std::string::npos) {
+        seconds_[line.substr(0, tab)] = std::strtod(line.c_str() + tab + 1, nullptr);
+      }
+    }
+  }
+
+  [[nodiscard]] auto get(const std::string& executable,
+                         const std::string& test) const -> double {
+    const auto it = seconds_.find(executable + '\t' + test);
+    return it == seconds_.end() ? unknown_duration : it->second;
+  }
+
+  auto set(const std::string& executable, const std::string& test,
+           double seconds) -> void {
+    seconds_[executable + '\t' + test] = seconds;
+  }
+
+  auto save() const -> void {
+    if (filename_ == "none") {
+      return;
+    }
+    auto out = std::ofstream{filename_};
+    for (const auto& [key, seconds] : seconds_) {
+      out << key << '\t' << seconds << '\n';
+    }
+  }
+
+ private:
+  std::string filename_{};
+  std::map<std::string, double> seconds_{};
+};
+
+/// outcome of a job which already ran
+struct result {
+  int status{};
+  double seconds{};
+  fs::path log{};
+};
+
+struct batch {
+  std::string executable{};
+  std::vector<std::string> tests{};  // empty: run the whole executable
+  double estimate{};
+  std::optional<result> listed{};  // ran as a whole by the listing job
+};
+
+/// splits the tests of `executable` into batches of about `batch_time`
+[[nodiscard]] auto make_batches(const std::string& executable,
+                                std::vector<std::string> tests,
+                                const durations& history, double batch_time)
+    -> std::vector<batch> {
+  if (tests.empty()) {
+    return {batch{executable, {}, history.get(executable, "*")}};
+  }
+  std::ranges::stable_sort(tests, std::greater{}, [&](const auto& test) {
+    return history.get(executable, test);
+  });
+  auto batches = std::vector<batch>{};
+  for (auto& test : tests) {
+    const auto seconds = history.get(executable, test);
+    if (batches.empty() or batches.back().estimate + seconds > batch_time) {
+      batches.push_back(batch{executable, {}, 0.});
+    }
+    batches.back().tests.push_back(std::move(test));
+    batches.back().estimate += seconds;
+  }
+  return batches;
+}
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  const auto opts = parse(argc, argv);
+  if (opts.executables.empty()) {
+    print_usage();
+    return 2;
+  }
+  const auto server = jobserver::from_env();
+  const auto tmp =
+      fs::temp_directory_path() / ("ut-run-" + std::to_string(::getpid()));
+  fs::create_directories(tmp);
+  auto history = durations{opts.durations_filename};
+
+  // query the top-level tests of each executable
+  auto tests = std::vector<std::vector<std::string>>(opts.executables.size());
+  auto listed = std::vector<std::optional<result>>(opts.executables.size());
+  auto jobs = std::vector<job>{};
+  for (auto i = 0u; i < opts.executables.size(); ++i) {
+    const auto id = std::to_string(i);
+    const auto list = tmp / ("list-" + id);
+    const auto log = tmp / ("list-" + id + ".log");
+    jobs.push_back(job{{opts.executables[i], "--list-test-names-only",
+                        "--state-file", "none", "-o", list.string()},
+                       log,
+                       [&, i, list, log](int status, double seconds) {
+                         // executables without a command line (tests in
+                         // main) don't write the list but run all their
+                         // tests, which is taken as their result
+                         if (not fs::exists(list)) {
+                           listed[i] = result{status, seconds, log};
+                           return;
+                         }
+                         auto in = std::ifstream{list};
+                         for (auto name = std::string{};
+                              status == 0 and std::getline(in, name);) {
+                           if (not name.empty()) {
+                             tests[i].push_back(name);
+                           }
+                         }
+                       }});
+  }
+  run(jobs, opts.jobs, server);
+
+  auto batches = std::vector<batch>{};
+  for (auto i = 0u; i < opts.executables.size(); ++i) {
+    if (listed[i]) {
+      batches.push_back(
+          batch{opts.executables[i], {}, listed[i]->seconds, listed[i]});
+      continue;
+    }
+    auto b = make_batches(opts.executables[i], std::move(tests[i]), history,
+                          opts.batch_time);
+    std::ranges::move(b, std::back_inserter(batches));
+  }
+  std::ranges::stable_sort(batches, std::greater{}, &batch::estimate);
+
+  // run the batches, longest first
+  struct {
+    std::size_t tests{};
+    std::size_t failures{};
+    double time{};
+  } total{};
+  auto suites = std::string{};
+  auto failed = 0u;
+  auto finished = 0u;
+  jobs.clear();
+  for (auto i = 0u; i < batches.size(); ++i) {
+    const auto& b = batches[i];
+    const auto id = std::to_string(i);
+    const auto xml = tmp / ("batch-" + id + ".xml");
+    auto args =
+        std::vector<std::string>{b.executable, "-r", "junit", "-o", xml.string()};
+    if (not b.tests.empty()) {
+      args.insert(args.end(), {"--state-file", "none"});
+      const auto input = tmp / ("batch-" + id + ".tests");
+      auto out = std::ofstream{input};
+      for (const auto& test : b.tests) {
+        out << test << '\n';
+      }
+      args.insert(args.end(), {"-f", input.string()});
+    }
+    const auto log = b.listed ? b.listed->log : tmp / ("batch-" + id + ".log");
+    auto next = job{std::move(args), log, [&, xml, log, i](int status,
+                                                           double seconds) {
+      const auto& current = batches[i];
+      const auto ok = WIFEXITED(status) and WEXITSTATUS(status) == 0;
+      failed += ok ? 0 : 1;
+      std::cout << '[' << ++finished << '/' << batches.size() << "] "
+                << (ok ? "PASSED " : "FAILED ") << seconds << "s "
+                << current.executable;
+      if (not current.tests.empty()) {
+        std::cout << " (" << current.tests.size() << " tests)";
+      }
+      std::cout << std::endl;
+      if (not ok) {
+        std::cerr << read_file(log);
+      }
+
+      const auto report = read_file(xml);
+      auto found = false;
+      for (auto begin = report.find("<testsuite ");
+           begin != std::string::npos;
+           begin = report.find("<testsuite ", begin + 1)) {
+        const auto end = report.find("</testsuite>", begin);
+        const auto suite = std::string_view{report}.substr(
+            begin, end == std::string::npos ? end : end - begin + 12);
+        if (suite.find("<testcase") == std::string_view::npos) {
+          continue;
+        }
+        found = true;
+        const auto tag = suite.substr(0, suite.find('>'));
+        total.tests += static_cast<std::size_t>(to_number(attribute(tag, "tests")));
+        total.failures +=
+            static_cast<std::size_t>(to_number(attribute(tag, "failures")));
+        total.time += to_number(attribute(tag, "time"));
+        suites.append(suite) += '\n';
+        // top-level tests are indented by a single space
+        auto lines = std::istringstream{std::string{suite}};
+        for (auto line = std::string{}; std::getline(lines, line);) {
+          if (line.starts_with(" <testcase ")) {
+            history.set(current.executable,
+                        attribute(line, "name"),
+                        to_number(attribute(line, "time")));
+          }
+        }
+      }
+      if (not found) {  // no JUnit report, account for the whole run
+        if (current.tests.empty()) {
+          history.set(current.executable, "*", seconds);
+        }
+        const auto name = fs::path{current.executable}.filename().string();
+        ++total.tests;
+        total.failures += ok ? 0 : 1;
+        total.time += seconds;
+        suites += "<testsuite name=\"" + name + "\" tests=\"1\" failures=\"" +
+                  (ok ? "0" : "1") + "\">\n <testcase classname=\"" + name +
+                  "\" name=\"" + name + "\" time=\"" + std::to_string(seconds) +
+                  "\"" + (ok ? " />\n" : ">\n  <failure />\n </testcase>\n") +
+                  "</testsuite>\n";
+      }
+    }};
+    if (b.listed) {
+      next.done(b.listed->status, b.listed->seconds);
+    } else {
+      jobs.push_back(std::move(next));
+    }
+  }
+  run(jobs, opts.jobs, server);
+  history.save();
+
+  if (not opts.output_filename.empty()) {
+    auto out = std::ofstream{opts.output_filename};
+    out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<testsuites name=\"all\" tests=\"" << total.tests
+        << "\" failures=\"" << total.failures << "\" time=\"" << total.time
+        << "\">\n"
+        << suites << "</testsuites>\n";
+  }
+  fs::remove_all(tmp);
+
+  std::cout << (failed ? "FAILED" : "PASSED") << ": " << batches.size()
+            << " batches from " << opts.executables.size() << " executables, "
+            << failed << " failed" << std::endl;
+  return failed ? 1 : 0;
+}